@@ -0,0 +1,195 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+
+/*
+* Internet checksum (RFC 1071) used by lwIP through the LWIP_CHKSUM macro.
+*
+* The function returns the 16 bits one's complement sum of the buffer, not
+* inverted, exactly like lwip_standard_chksum.  Words are summed as they are
+* stored in memory, the result is thus in network byte order.  The SSE2 or
+* AVX2 implementation is selected at the first call using cpuid.
+*/
+#include <stddef.h>
+#include <string.h>
+
+#include <lwip/opt.h>
+#include <lwip/arch.h>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#define CHKSUM_SIMD_SUPPORT 1
+#include <intrin.h>
+#include <immintrin.h>
+#else
+#define CHKSUM_SIMD_SUPPORT 0
+#endif
+
+
+typedef u64_t(*chksum_fn)(const u8_t* data, size_t len);
+
+
+/* Folds a 64 bits accumulator to 16 bits. */
+static u16_t fold64(u64_t sum)
+{
+	sum = (sum & 0xffffffffULL) + (sum >> 32);
+	sum = (sum & 0xffffffffULL) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+
+	return (u16_t)sum;
+}
+
+
+/* Sums 16 bits words, a trailing byte is added as the low order byte. */
+static u64_t chksum_scalar(const u8_t* data, size_t len)
+{
+	u64_t sum = 0;
+	u32_t word;
+
+	while (len >= 4) {
+		memcpy(&word, data, 4);
+		sum += word;
+		data += 4;
+		len -= 4;
+	}
+
+	if (len >= 2) {
+		u16_t half;
+		memcpy(&half, data, 2);
+		sum += half;
+		data += 2;
+		len -= 2;
+	}
+
+	if (len)
+		sum += *data;
+
+	return sum;
+}
+
+
+#if CHKSUM_SIMD_SUPPORT
+
+/* Number of vectors summed before the 32 bits lanes are flushed.  Each lane
+*  receives two 16 bits words per vector, 4096 vectors can not overflow. */
+#define CHKSUM_BLOCK 4096
+
+static u64_t chksum_sse2(const u8_t* data, size_t len)
+{
+	const __m128i zero = _mm_setzero_si128();
+	u64_t sum = 0;
+
+	while (len >= 16) {
+		__m128i acc = _mm_setzero_si128();
+		size_t count = len / 16 < CHKSUM_BLOCK ? len / 16 : CHKSUM_BLOCK;
+
+		len -= count * 16;
+		while (count--) {
+			const __m128i v = _mm_loadu_si128((const __m128i*)data);
+			acc = _mm_add_epi32(acc, _mm_unpacklo_epi16(v, zero));
+			acc = _mm_add_epi32(acc, _mm_unpackhi_epi16(v, zero));
+			data += 16;
+		}
+
+		/* flush the 4 lanes */
+		u32_t lanes[4];
+		_mm_storeu_si128((__m128i*)lanes, acc);
+		sum += (u64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+	}
+
+	return sum + chksum_scalar(data, len);
+}
+
+
+static u64_t chksum_avx2(const u8_t* data, size_t len)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	u64_t sum = 0;
+
+	while (len >= 32) {
+		__m256i acc = _mm256_setzero_si256();
+		size_t count = len / 32 < CHKSUM_BLOCK ? len / 32 : CHKSUM_BLOCK;
+
+		len -= count * 32;
+		while (count--) {
+			const __m256i v = _mm256_loadu_si256((const __m256i*)data);
+			acc = _mm256_add_epi32(acc, _mm256_unpacklo_epi16(v, zero));
+			acc = _mm256_add_epi32(acc, _mm256_unpackhi_epi16(v, zero));
+			data += 32;
+		}
+
+		/* flush the 8 lanes */
+		u32_t lanes[8];
+		_mm256_storeu_si256((__m256i*)lanes, acc);
+		for (int i = 0; i < 8; i++)
+			sum += lanes[i];
+	}
+
+	/* Avoid the AVX to SSE transition penalty. */
+	_mm256_zeroupper();
+
+	return sum + chksum_sse2(data, len);
+}
+
+
+static int has_avx2(void)
+{
+	int regs[4];
+
+	__cpuid(regs, 0);
+	if (regs[0] < 7)
+		return 0;
+
+	/* The OS must save the YMM registers (OSXSAVE + AVX + XCR0). */
+	__cpuid(regs, 1);
+	if ((regs[2] & (1 << 27)) == 0 || (regs[2] & (1 << 28)) == 0)
+		return 0;
+
+	if ((_xgetbv(0) & 0x6) != 0x6)
+		return 0;
+
+	__cpuidex(regs, 7, 0);
+	return (regs[1] & (1 << 5)) != 0;
+}
+
+
+static int has_sse2(void)
+{
+	int regs[4];
+
+	__cpuid(regs, 1);
+	return (regs[3] & (1 << 26)) != 0;
+}
+
+#endif /* CHKSUM_SIMD_SUPPORT */
+
+
+static chksum_fn select_chksum(void)
+{
+#if CHKSUM_SIMD_SUPPORT
+	if (has_avx2())
+		return chksum_avx2;
+
+	if (has_sse2())
+		return chksum_sse2;
+#endif
+
+	return chksum_scalar;
+}
+
+
+u16_t sys_arch_chksum(const void* dataptr, int len)
+{
+	/* The selection is idempotent, a concurrent first call is harmless. */
+	static chksum_fn chksum = NULL;
+
+	if (chksum == NULL)
+		chksum = select_chksum();
+
+	return len > 0 ? fold64(chksum((const u8_t*)dataptr, (size_t)len)) : 0;
+}
@@ -47,11 +47,26 @@
 /* These functions are used from NO_SYS also, for precise timer triggering */
 static LARGE_INTEGER freq, sys_start_time;
 
+/* sys_now() is called from several threads, the clock is initialized once. */
+static INIT_ONCE sys_timing_once = INIT_ONCE_STATIC_INIT;
 
-static void sys_init_timing()
+
+static BOOL CALLBACK sys_init_timing_once(PINIT_ONCE once, PVOID param, PVOID *context)
 {
+	LWIP_UNUSED_ARG(once);
+	LWIP_UNUSED_ARG(param);
+	LWIP_UNUSED_ARG(context);
+
 	QueryPerformanceFrequency(&freq);
 	QueryPerformanceCounter(&sys_start_time);
+
+	return TRUE;
+}
+
+
+static void sys_init_timing()
+{
+	InitOnceExecuteOnce(&sys_timing_once, sys_init_timing_once, NULL, NULL);
 }
 
 static LONGLONG sys_get_ms_longlong()
@@ -59,9 +74,7 @@ static LONGLONG sys_get_ms_longlong()
 	LONGLONG ret;
 	LARGE_INTEGER now;
 #if NO_SYS
-	if (freq.QuadPart == 0) {
-		sys_init_timing();
-	}
+	sys_init_timing();
 #endif /* NO_SYS */
 	QueryPerformanceCounter(&now);
 	ret = now.QuadPart - sys_start_time.QuadPart;
@@ -70,14 +83,14 @@ static LONGLONG sys_get_ms_longlong()
 
 u32_t sys_jiffies()
 {
-//	return (u32_t)sys_get_ms_longlong();
-	return GetTickCount();
+	return (u32_t)sys_get_ms_longlong();
 }
 
+/* The lwIP clock is based on the performance counter, GetTickCount has a
+   resolution of 10 to 16 ms which is too coarse for short timers. */
 u32_t sys_now()
 {
-//	return (u32_t)sys_get_ms_longlong();
-	return GetTickCount();
+	return (u32_t)sys_get_ms_longlong();
 }
 
 
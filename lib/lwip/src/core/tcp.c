@@ -1197,6 +1197,7 @@ tcp_slowtmr(void)
 {
   struct tcp_pcb *pcb, *prev;
   tcpwnd_size_t eff_wnd;
+  err_t rexmit_err;
   u8_t pcb_remove;      /* flag if a PCB should be removed */
   u8_t pcb_reset;       /* flag if a RST should be sent when removing */
   err_t err;
@@ -1281,28 +1282,36 @@ tcp_slowtmr_start:
           LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_slowtmr: rtime %"S16_F
                                       " pcb->rto %"S16_F"\n",
                                       pcb->rtime, pcb->rto));
+          /* In tunnel mode, the segments following the first unacked segment are
+             most likely still queued in the tunnel: only the first one is sent again. */
+          rexmit_err = tcp_tunnel_mode(pcb) ? tcp_rexmit(pcb) : tcp_rexmit_rto_prepare(pcb);
           /* If prepare phase fails but we have unsent data but no unacked data,
              still execute the backoff calculations below, as this means we somehow
              failed to send segment. */
-          if ((tcp_rexmit_rto_prepare(pcb) == ERR_OK) || ((pcb->unacked == NULL) && (pcb->unsent != NULL))) {
+          if ((rexmit_err == ERR_OK) || ((pcb->unacked == NULL) && (pcb->unsent != NULL))) {
             /* Double retransmission time-out unless we are trying to
              * connect to somebody (i.e., we are in SYN_SENT). */
             if (pcb->state != SYN_SENT) {
               u8_t backoff_idx = LWIP_MIN(pcb->nrtx, sizeof(tcp_backoff) - 1);
               int calc_rto = ((pcb->sa >> 3) + pcb->sv) << tcp_backoff[backoff_idx];
               pcb->rto = (s16_t)LWIP_MIN(calc_rto, 0x7FFF);
+              TCP_RTO_APPLY_MIN(pcb);
             }
 
             /* Reset the retransmission timer. */
             pcb->rtime = 0;
 
-            /* Reduce congestion window and ssthresh. */
-            eff_wnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
-            pcb->ssthresh = eff_wnd >> 1;
-            if (pcb->ssthresh < (tcpwnd_size_t)(pcb->mss << 1)) {
-              pcb->ssthresh = (tcpwnd_size_t)(pcb->mss << 1);
+            /* Reduce congestion window and ssthresh.  In tunnel mode, the
+               lower layer does not lose segments, a time-out only means that
+               the tunnel stalled: the congestion window is kept. */
+            if (!tcp_tunnel_mode(pcb)) {
+              eff_wnd = LWIP_MIN(pcb->cwnd, pcb->snd_wnd);
+              pcb->ssthresh = eff_wnd >> 1;
+              if (pcb->ssthresh < (tcpwnd_size_t)(pcb->mss << 1)) {
+                pcb->ssthresh = (tcpwnd_size_t)(pcb->mss << 1);
+              }
+              pcb->cwnd = pcb->mss;
             }
-            pcb->cwnd = pcb->mss;
             LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_slowtmr: cwnd %"TCPWNDSIZE_F
                                          " ssthresh %"TCPWNDSIZE_F"\n",
                                          pcb->cwnd, pcb->ssthresh));
@@ -1310,7 +1319,11 @@ tcp_slowtmr_start:
 
             /* The following needs to be called AFTER cwnd is set to one
                mss - STJ */
-            tcp_rexmit_rto_commit(pcb);
+            if (tcp_tunnel_mode(pcb)) {
+              tcp_output(pcb);
+            } else {
+              tcp_rexmit_rto_commit(pcb);
+            }
           }
         }
       }
@@ -1654,6 +1667,31 @@ tcp_setprio(struct tcp_pcb *pcb, u8_t prio)
   pcb->prio = prio;
 }
 
+#if LWIP_TCP_TUNNEL_MODE
+/**
+ * @ingroup tcp
+ * Switches a connection to the tunnel mode.  This function must be called
+ * before tcp_connect().
+ *
+ * @param pcb the tcp_pcb to manipulate
+ * @param rto_min_ms lower bound of the retransmission time-out (ms)
+ */
+void
+tcp_set_tunnel_mode(struct tcp_pcb *pcb, u32_t rto_min_ms)
+{
+  u32_t rto_min;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  LWIP_ERROR("tcp_set_tunnel_mode: invalid pcb", pcb != NULL, return);
+
+  rto_min = (rto_min_ms + TCP_SLOW_INTERVAL - 1) / TCP_SLOW_INTERVAL;
+  pcb->tunnel_mode = 1;
+  pcb->rto_min = (s16_t)LWIP_MIN(rto_min, 0x7FFF);
+  TCP_RTO_APPLY_MIN(pcb);
+}
+#endif /* LWIP_TCP_TUNNEL_MODE */
+
 #if TCP_QUEUE_OOSEQ
 /**
  * Returns a copy of the given TCP segment.
@@ -87,6 +87,13 @@ static struct pbuf *recv_data;
 
 struct tcp_pcb *tcp_input_pcb;
 
+#if LWIP_TCP_INPUT_BATCH
+/* Set between tcp_input_batch_begin and tcp_input_batch_end. */
+static u8_t tcp_input_batching;
+
+struct tcp_input_batch_stats tcp_batch_stats;
+#endif /* LWIP_TCP_INPUT_BATCH */
+
 /* Forward declarations. */
 static err_t tcp_process(struct tcp_pcb *pcb);
 static void tcp_receive(struct tcp_pcb *pcb);
@@ -105,6 +112,49 @@ static void tcp_remove_sacks_gt(struct tcp_pcb *pcb, u32_t seq);
 #endif /* TCP_OOSEQ_BYTES_LIMIT || TCP_OOSEQ_PBUFS_LIMIT */
 #endif /* LWIP_TCP_SACK_OUT */
 
+#if LWIP_TCP_INPUT_BATCH
+/**
+ * Starts a batch of input segments.  Segments received until
+ * tcp_input_batch_end() is called are processed immediately but the
+ * output of the pcbs is deferred: a single ACK is generated per pcb.
+ */
+void
+tcp_input_batch_begin(void)
+{
+  LWIP_ASSERT_CORE_LOCKED();
+
+  tcp_input_batching = 1;
+  tcp_batch_stats.batches++;
+}
+
+/**
+ * Ends a batch of input segments and sends the deferred output.
+ */
+void
+tcp_input_batch_end(void)
+{
+  /* A pcb that received a FIN during the batch can have moved to the
+     TIME_WAIT list, the ACK of the FIN is still pending. */
+  struct tcp_pcb *lists[2];
+  struct tcp_pcb *pcb;
+  size_t i;
+
+  LWIP_ASSERT_CORE_LOCKED();
+
+  tcp_input_batching = 0;
+  lists[0] = tcp_active_pcbs;
+  lists[1] = tcp_tw_pcbs;
+  for (i = 0; i < LWIP_ARRAYSIZE(lists); i++) {
+    for (pcb = lists[i]; pcb != NULL; pcb = pcb->next) {
+      if (pcb->flags & TF_INBATCH) {
+        tcp_clear_flags(pcb, TF_INBATCH);
+        tcp_output(pcb);
+      }
+    }
+  }
+}
+#endif /* LWIP_TCP_INPUT_BATCH */
+
 /**
  * The initial input processing of TCP. It verifies the TCP header, demultiplexes
  * the segment between the PCBs and passes it on to tcp_process(), which implements
@@ -134,6 +184,9 @@ tcp_input(struct pbuf *p, struct netif *inp)
 
   TCP_STATS_INC(tcp.recv);
   MIB2_STATS_INC(mib2.tcpinsegs);
+#if LWIP_TCP_INPUT_BATCH
+  tcp_batch_stats.segs++;
+#endif /* LWIP_TCP_INPUT_BATCH */
 
   tcphdr = (struct tcp_hdr *)p->payload;
 
@@ -550,7 +603,15 @@ tcp_input(struct pbuf *p, struct netif *inp)
           goto aborted;
         }
         /* Try to send something out. */
-        tcp_output(pcb);
+#if LWIP_TCP_INPUT_BATCH
+        if (tcp_input_batching) {
+          /* The ACK of this segment is merged with the next ones. */
+          tcp_set_flags(pcb, TF_INBATCH);
+        } else
+#endif /* LWIP_TCP_INPUT_BATCH */
+        {
+          tcp_output(pcb);
+        }
 #if TCP_INPUT_DEBUG
 #if TCP_DEBUG
         tcp_debug_print_state(pcb->state);
@@ -880,7 +941,8 @@ tcp_process(struct tcp_pcb *pcb)
         pcb->mss = tcp_eff_send_mss(pcb->mss, &pcb->local_ip, &pcb->remote_ip);
 #endif /* TCP_CALCULATE_EFF_SEND_MSS */
 
-        pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
+        pcb->cwnd = tcp_tunnel_mode(pcb) ?
+                    LWIP_TCP_TUNNEL_INITIAL_CWND(pcb->mss) : LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
         LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_process (SENT): cwnd %"TCPWNDSIZE_F
                                      " ssthresh %"TCPWNDSIZE_F"\n",
                                      pcb->cwnd, pcb->ssthresh));
@@ -973,7 +1035,8 @@ tcp_process(struct tcp_pcb *pcb)
             recv_acked--;
           }
 
-          pcb->cwnd = LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
+          pcb->cwnd = tcp_tunnel_mode(pcb) ?
+                      LWIP_TCP_TUNNEL_INITIAL_CWND(pcb->mss) : LWIP_TCP_CALC_INITIAL_CWND(pcb->mss);
           LWIP_DEBUGF(TCP_CWND_DEBUG, ("tcp_process (SYN_RCVD): cwnd %"TCPWNDSIZE_F
                                        " ssthresh %"TCPWNDSIZE_F"\n",
                                        pcb->cwnd, pcb->ssthresh));
@@ -1249,6 +1312,7 @@ tcp_receive(struct tcp_pcb *pcb)
 
       /* Reset the retransmission time-out. */
       pcb->rto = (s16_t)((pcb->sa >> 3) + pcb->sv);
+      TCP_RTO_APPLY_MIN(pcb);
 
       /* Record how much data this ACK acks */
       acked = (tcpwnd_size_t)(ackno - pcb->lastack);
@@ -1364,6 +1428,7 @@ tcp_receive(struct tcp_pcb *pcb)
       m = (s16_t)(m - (pcb->sv >> 2));
       pcb->sv = (s16_t)(pcb->sv + m);
       pcb->rto = (s16_t)((pcb->sa >> 3) + pcb->sv);
+      TCP_RTO_APPLY_MIN(pcb);
 
       LWIP_DEBUGF(TCP_RTO_DEBUG, ("tcp_receive: RTO %"U16_F" (%"U16_F" milliseconds)\n",
                                   pcb->rto, (u16_t)(pcb->rto * TCP_SLOW_INTERVAL)));
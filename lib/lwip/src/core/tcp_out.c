@@ -1539,6 +1539,14 @@ tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif
     pcb->rtime = 0;
   }
 
+#if LWIP_TCP_TUNNEL_MODE
+  if (TCP_SEQ_LT(lwip_ntohl(seg->tcphdr->seqno), pcb->snd_nxt)) {
+    /* This segment was already sent */
+    pcb->rexmit_segs++;
+    pcb->rexmit_bytes += seg->len;
+  }
+#endif /* LWIP_TCP_TUNNEL_MODE */
+
   if (pcb->rttest == 0) {
     pcb->rttest = tcp_ticks;
     pcb->rtseq = lwip_ntohl(seg->tcphdr->seqno);
@@ -1796,20 +1804,23 @@ tcp_rexmit_fast(struct tcp_pcb *pcb)
                  (u16_t)pcb->dupacks, pcb->lastack,
                  lwip_ntohl(pcb->unacked->tcphdr->seqno)));
     if (tcp_rexmit(pcb) == ERR_OK) {
-      /* Set ssthresh to half of the minimum of the current
-       * cwnd and the advertised window */
-      pcb->ssthresh = LWIP_MIN(pcb->cwnd, pcb->snd_wnd) / 2;
-
-      /* The minimum value for ssthresh should be 2 MSS */
-      if (pcb->ssthresh < (2U * pcb->mss)) {
-        LWIP_DEBUGF(TCP_FR_DEBUG,
-                    ("tcp_receive: The minimum value for ssthresh %"TCPWNDSIZE_F
-                     " should be min 2 mss %"U16_F"...\n",
-                     pcb->ssthresh, (u16_t)(2 * pcb->mss)));
-        pcb->ssthresh = 2 * pcb->mss;
-      }
+      /* In tunnel mode, the congestion window is not reduced. */
+      if (!tcp_tunnel_mode(pcb)) {
+        /* Set ssthresh to half of the minimum of the current
+         * cwnd and the advertised window */
+        pcb->ssthresh = LWIP_MIN(pcb->cwnd, pcb->snd_wnd) / 2;
+
+        /* The minimum value for ssthresh should be 2 MSS */
+        if (pcb->ssthresh < (2U * pcb->mss)) {
+          LWIP_DEBUGF(TCP_FR_DEBUG,
+                      ("tcp_receive: The minimum value for ssthresh %"TCPWNDSIZE_F
+                       " should be min 2 mss %"U16_F"...\n",
+                       pcb->ssthresh, (u16_t)(2 * pcb->mss)));
+          pcb->ssthresh = 2 * pcb->mss;
+        }
 
-      pcb->cwnd = pcb->ssthresh + 3 * pcb->mss;
+        pcb->cwnd = pcb->ssthresh + 3 * pcb->mss;
+      }
       tcp_set_flags(pcb, TF_INFR);
 
       /* Reset the retransmission timer to prevent immediate rto retransmissions */
@@ -2131,6 +2142,9 @@ tcp_send_empty_ack(struct tcp_pcb *pcb)
   } else {
     /* remove ACK flags from the PCB, as we sent an empty ACK now */
     tcp_clear_flags(pcb, TF_ACK_DELAY | TF_ACK_NOW);
+#if LWIP_TCP_INPUT_BATCH
+    tcp_batch_stats.acks++;
+#endif /* LWIP_TCP_INPUT_BATCH */
   }
 
   return err;
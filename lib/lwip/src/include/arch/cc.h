@@ -85,6 +85,15 @@ extern "C" {
 }
 #endif
 
+/* Internet checksum, see LWIP_CHKSUM in lwipopts.h */
+#ifdef __cplusplus
+extern "C" {
+#endif
+	extern unsigned short sys_arch_chksum(const void *dataptr, int len);
+#ifdef __cplusplus
+}
+#endif
+
 extern void sys_log_error(const char *format, ...);
 extern void sys_log_diag(const char *format, ...);
 
@@ -1375,6 +1375,34 @@
 #define LWIP_TCP_RTO_TIME               3000
 #endif
 
+/**
+ * LWIP_TCP_TUNNEL_MODE==1: Allow a tcp_pcb to be switched to the tunnel mode
+ * (see tcp_set_tunnel_mode).  In this mode, the RTO has a lower bound, the
+ * initial congestion window is large and retransmissions do not reduce the
+ * congestion window.  This mode is intended for connections carried by a
+ * reliable lower layer (TCP over TCP).
+ */
+#if !defined LWIP_TCP_TUNNEL_MODE || defined __DOXYGEN__
+#define LWIP_TCP_TUNNEL_MODE            0
+#endif
+
+/**
+ * LWIP_TCP_TUNNEL_INITIAL_CWND: Initial congestion window (bytes) of a
+ * tcp_pcb in tunnel mode.
+ */
+#if !defined LWIP_TCP_TUNNEL_INITIAL_CWND || defined __DOXYGEN__
+#define LWIP_TCP_TUNNEL_INITIAL_CWND(mss) ((tcpwnd_size_t)LWIP_MIN(TCP_SND_BUF, 16U * (mss)))
+#endif
+
+/**
+ * LWIP_TCP_INPUT_BATCH==1: Allow the link layer to group the segments received
+ * together (see tcp_input_batch_begin).  The output (ACKs) of the active pcbs
+ * is deferred until the end of the batch.
+ */
+#if !defined LWIP_TCP_INPUT_BATCH || defined __DOXYGEN__
+#define LWIP_TCP_INPUT_BATCH            0
+#endif
+
 /**
  * TCP_SND_BUF: TCP sender buffer space (bytes).
  * To achieve good performance, this should be at least 2 * TCP_MSS.
@@ -151,6 +151,13 @@ err_t            tcp_process_refused_data(struct tcp_pcb *pcb);
 
 #define TCP_TCPLEN(seg) ((seg)->len + (((TCPH_FLAGS((seg)->tcphdr) & (TCP_FIN | TCP_SYN)) != 0) ? 1U : 0U))
 
+/** Applies the lower bound of the retransmission time-out (tunnel mode) */
+#if LWIP_TCP_TUNNEL_MODE
+#define TCP_RTO_APPLY_MIN(pcb) do { if ((pcb)->rto < (pcb)->rto_min) { (pcb)->rto = (pcb)->rto_min; } } while(0)
+#else
+#define TCP_RTO_APPLY_MIN(pcb)
+#endif /* LWIP_TCP_TUNNEL_MODE */
+
 /** Flags used on input processing, not on pcb->flags
 */
 #define TF_RESET     (u8_t)0x08U   /* Connection was reset. */
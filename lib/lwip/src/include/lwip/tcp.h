@@ -269,6 +269,9 @@ struct tcp_pcb {
 #define TF_RTO         0x0800U /* RTO timer has fired, in-flight data moved to unsent and being retransmitted */
 #if LWIP_TCP_SACK_OUT
 #define TF_SACK        0x1000U /* Selective ACKs enabled */
+#endif
+#if LWIP_TCP_INPUT_BATCH
+#define TF_INBATCH     0x2000U /* Output deferred until the end of the input batch */
 #endif
 
   /* the rest of the fields are in host byte order
@@ -315,6 +318,14 @@ struct tcp_pcb {
   /* first byte following last rto byte */
   u32_t rto_end;
 
+#if LWIP_TCP_TUNNEL_MODE
+  /* tunnel mode, see tcp_set_tunnel_mode() */
+  u8_t tunnel_mode;
+  s16_t rto_min;       /* lower bound of rto (in ticks of TCP_SLOW_INTERVAL) */
+  u32_t rexmit_segs;   /* number of retransmitted segments */
+  u32_t rexmit_bytes;  /* number of retransmitted bytes */
+#endif /* LWIP_TCP_TUNNEL_MODE */
+
   /* sender variables */
   u32_t snd_nxt;   /* next new seqno to be sent */
   u32_t snd_wl1, snd_wl2; /* Sequence and acknowledgement numbers of last
@@ -475,6 +486,29 @@ err_t            tcp_write   (struct tcp_pcb *pcb, const void *dataptr, u16_t le
 
 void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 
+#if LWIP_TCP_INPUT_BATCH
+/** Counters of the input batches */
+struct tcp_input_batch_stats {
+  u32_t batches;    /* number of input batches */
+  u32_t segs;       /* number of received segments */
+  u32_t acks;       /* number of empty ACKs sent */
+};
+
+extern struct tcp_input_batch_stats tcp_batch_stats;
+
+void             tcp_input_batch_begin(void);
+void             tcp_input_batch_end(void);
+#endif /* LWIP_TCP_INPUT_BATCH */
+
+#if LWIP_TCP_TUNNEL_MODE
+void             tcp_set_tunnel_mode(struct tcp_pcb *pcb, u32_t rto_min_ms);
+#define          tcp_tunnel_mode(pcb)     ((pcb)->tunnel_mode)
+#define          tcp_rexmit_segs(pcb)     ((pcb)->rexmit_segs)
+#define          tcp_rexmit_bytes(pcb)    ((pcb)->rexmit_bytes)
+#else
+#define          tcp_tunnel_mode(pcb)     0
+#endif /* LWIP_TCP_TUNNEL_MODE */
+
 err_t            tcp_output  (struct tcp_pcb *pcb);
 
 err_t            tcp_tcp_get_tcp_addrinfo(struct tcp_pcb *pcb, int local, ip_addr_t *addr, u16_t *port);
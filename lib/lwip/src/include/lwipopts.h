@@ -82,6 +82,12 @@
 /* LWIP_TCP_KEEPALIVE==1: Enable TCP_KEEPIDLE, TCP_KEEPINTVL and TCP_KEEPCNT */
 #define LWIP_TCP_KEEPALIVE		1
 
+/* LWIP_TCP_TUNNEL_MODE==1: Enable the TCP over TCP aware mode (see tcp_set_tunnel_mode) */
+#define LWIP_TCP_TUNNEL_MODE	1
+
+/* LWIP_TCP_INPUT_BATCH==1: The segments of a tunnel read are acknowledged together */
+#define LWIP_TCP_INPUT_BATCH	1
+
 /*>> Pbuf options */
 
 /* PBUF_LINK_HLEN: the number of bytes that should be allocated for a link level header. */
@@ -97,8 +103,19 @@
 /* LWIP_SOCKET==1: Enable Socket API (require to use sockets.c) */
 #define LWIP_SOCKET				0
 
-/* Number of simultaneously active timeouts, add 1 for the tunneler, 2 * the number of active forwarders */
-#define MEMP_NUM_SYS_TIMEOUT	(LWIP_TCP + IP_REASSEMBLY + PPP_NUM_TIMEOUTS + 2 * MEMP_NUM_TCP_PCB )	
+/* Number of simultaneously active timeouts, add 2 for the tunneler (close and shaper timers), 
+   3 * the number of active forwarders (flush and delayed acknowledgment timers) */
+#define MEMP_NUM_SYS_TIMEOUT	(LWIP_TCP + IP_REASSEMBLY + PPP_NUM_TIMEOUTS + 2 + 3 * MEMP_NUM_TCP_PCB )	
+
+
+/*>> Checksum options */
+
+/* LWIP_CHKSUM: SIMD implementation of the Internet checksum (see arch/chksum_arch.c) */
+#define LWIP_CHKSUM				sys_arch_chksum
+
+/* LWIP_CHECKSUM_CTRL_PER_NETIF==1: Checksum verification can be disabled
+   on the PPP interface, the tunnel is already protected by TLS. */
+#define LWIP_CHECKSUM_CTRL_PER_NETIF	1
 
 
 /*>> PPP options (see ppp_opts.h) */
@@ -0,0 +1,78 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "CrtCache.h"
+
+#include <algorithm>
+
+
+namespace fw {
+	using namespace utl;
+
+	// The maximum number of entries.
+	static constexpr size_t MAX_ENTRIES = 8;
+
+
+	CrtCache::CrtCache(uint32_t ttl) :
+		_logger(Logger::get_logger()),
+		_ttl(ttl),
+		_entries(),
+		_mutex()
+	{
+		DEBUG_CTOR(_logger);
+	}
+
+
+	CrtCache::~CrtCache()
+	{
+		DEBUG_DTOR(_logger);
+	}
+
+
+	bool CrtCache::find(const CrtDigest& digest, uint64_t& verify_time)
+	{
+		Mutex::Lock lock{ _mutex };
+
+		// Remove the expired entries.
+		const std::time_t now = std::time(nullptr);
+		_entries.erase(
+			std::remove_if(_entries.begin(), _entries.end(), [now](const entry& e) {
+				return e.expires <= now || ::mbedtls_x509_time_is_past(&e.valid_to); }),
+			_entries.end());
+
+		const auto it = std::find_if(_entries.cbegin(), _entries.cend(),
+			[&digest](const entry& e) { return e.digest == digest; });
+		if (it == _entries.cend())
+			return false;
+
+		verify_time = it->verify_time;
+
+		return true;
+	}
+
+
+	void CrtCache::add(const CrtDigest& digest, const mbedtls_x509_crt* crt, uint64_t verify_time)
+	{
+		DEBUG_ENTER_FMT(_logger, "verify_time=%llu", verify_time);
+		Mutex::Lock lock{ _mutex };
+
+		if (!crt)
+			return;
+
+		// Replace the entry of this certificate, the most recent entries are kept.
+		_entries.erase(
+			std::remove_if(_entries.begin(), _entries.end(), [&digest](const entry& e) { return e.digest == digest; }),
+			_entries.end());
+		if (_entries.size() >= MAX_ENTRIES)
+			_entries.erase(_entries.begin());
+
+		_entries.push_back(entry{ digest, std::time(nullptr) + _ttl, crt->valid_to, verify_time });
+	}
+
+
+	const char* CrtCache::__class__ = "CrtCache";
+}
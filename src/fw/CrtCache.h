@@ -0,0 +1,94 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <vector>
+#include <mbedtls/x509_crt.h>
+#include "fw/CrtDigest.h"
+#include "util/Logger.h"
+#include "util/Mutex.h"
+
+
+namespace fw {
+
+	/**
+	* CrtCache: the firewall certificates verified by previous connections.
+	*
+	* A certificate is identified by its digest.  While an entry is valid,
+	* the connections to the firewall only compare the digest of the received
+	* certificate instead of verifying its chain again.  An entry expires after
+	* a fixed delay or when the certificate expires, the chain is then verified
+	* again.  The expiry does not depend on the revocation information, a
+	* certificate revoked while its entry is valid is accepted until the entry
+	* expires, the delay is therefore short.
+	*
+	* The cache is shared by the portal clients, the access is serialized.
+	*/
+	class CrtCache final
+	{
+	public:
+		/**
+		 * Creates a certificate cache.
+		 *
+		 * @param ttl The lifetime of an entry (s).
+		*/
+		explicit CrtCache(uint32_t ttl = DEFAULT_TTL);
+		~CrtCache();
+
+		CrtCache(const CrtCache& other) = delete;
+		CrtCache& operator=(const CrtCache& other) = delete;
+
+		/**
+		 * Searches a verified certificate.
+		 *
+		 * @param digest      The digest of the certificate.
+		 * @param verify_time The time spent to verify the certificate (us).
+		 *
+		 * @return true if the certificate was verified and the entry is valid.
+		*/
+		bool find(const CrtDigest& digest, uint64_t& verify_time);
+
+		/**
+		 * Adds a verified certificate.
+		 *
+		 * @param digest      The digest of the certificate.
+		 * @param crt         The certificate.
+		 * @param verify_time The time spent to verify the certificate (us).
+		*/
+		void add(const CrtDigest& digest, const mbedtls_x509_crt* crt, uint64_t verify_time);
+
+		// The default lifetime of an entry.
+		static const uint32_t DEFAULT_TTL = 5 * 60;
+
+	private:
+		// The class name
+		static const char* __class__;
+
+		// A reference to the application logger.
+		utl::Logger* const _logger;
+
+		// The lifetime of an entry.
+		const uint32_t _ttl;
+
+		struct entry {
+			CrtDigest digest;
+			std::time_t expires;			// expiration time of the entry
+			mbedtls_x509_time valid_to;		// expiration time of the certificate
+			uint64_t verify_time;			// time spent to verify the certificate (us)
+		};
+
+		// The entries, the most recent at the end.
+		std::vector<entry> _entries;
+
+		// Mutex to serialize the access to the entries.
+		utl::Mutex _mutex;
+	};
+
+}
@@ -27,6 +27,13 @@ namespace fw {
 	}
 
 
+	CrtDigest::CrtDigest(const unsigned char* digest) :
+		CrtDigest()
+	{
+		std::memcpy(_digest, digest, sizeof(_digest));
+	}
+
+
 	bool CrtDigest::operator== (const CrtDigest& other) const
 	{
 		return std::memcmp(_digest, other._digest, sizeof(_digest)) == 0;
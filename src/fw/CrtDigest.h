@@ -7,6 +7,7 @@
 */
 #pragma once
 
+#include <cstddef>
 #include <mbedtls/x509_crt.h>
 
 
@@ -29,6 +30,16 @@ namespace fw {
 		 */
 		explicit CrtDigest(const mbedtls_x509_crt* crt);
 
+		/* Creates the digest from a stored hash.
+		 *
+		 * @param digest A buffer of DIGEST_SIZE bytes
+		 */
+		explicit CrtDigest(const unsigned char* digest);
+
+		/* Returns the hash.
+		 */
+		inline const unsigned char* data() const noexcept { return _digest; }
+
 		/* Compares for equality this digest with another.
 		 *
 		 * @param other The other digest to compare
@@ -43,9 +54,12 @@ namespace fw {
 		 */
 		bool operator!= (const CrtDigest& other) const;
 
+		// The size of the hash.
+		static const size_t DIGEST_SIZE = 32;
+
 	private:
 		// A SHA256 hash of a certificate
-		unsigned char _digest[32];
+		unsigned char _digest[DIGEST_SIZE];
 	};
 
 }
@@ -11,6 +11,7 @@
 #include <memory>
 #include <stdexcept>
 #include <mbedtls/x509_crt.h>
+#include "http/BufferSink.h"
 #include "http/Request.h"
 #include "http/Cookie.h"
 #include "http/Cookies.h"
@@ -20,27 +21,47 @@
 #include "util/pugixml.hpp"
 #include "util/StringMap.h"
 #include "util/StrUtil.h"
+#include "util/SysUtil.h"
 #include "util/X509Crt.h"
 
 
 namespace fw {
 
+	// Maximum size of the SSL VPN configuration.
+	static constexpr size_t MAX_CONFIG_SIZE = 1024 * 1024;
+
+
 	FirewallClient::FirewallClient(const net::Endpoint& ep, const std::string& realm, const net::TlsConfig& config):
 		HttpsClient(ep, config),
 		_peer_crt_digest(),
 		_cookie_jar(),
+		_sslvpn_config(),
+		_tls_session(std::make_shared<net::TlsSession>()),
+		_session_store(),
+		_dtls_config(nullptr),
+		_crt_cache(nullptr),
+		_crt_cache_hits(0),
+		_crt_time_saved(0),
+		_persist_session(false),
 		_mutex(),
 		_realm(realm)
 	{
 		DEBUG_CTOR(_logger);
 
 		set_hostname_verification(true);
+		set_session_cache(_tls_session);
 	}
 
 
 	FirewallClient::~FirewallClient()
 	{
 		DEBUG_DTOR(_logger);
+
+		if (_crt_cache_hits > 0) {
+			LOG_DEBUG(_logger, "certificate verifications skipped=%u time saved=%llu us",
+				_crt_cache_hits,
+				_crt_time_saved);
+		}
 	}
 
 
@@ -52,6 +73,14 @@ namespace fw {
 
 		_logger->info(">> connecting to %s", host().to_string().c_str());
 
+		// Try to resume the session saved by a previous execution.
+		CrtDigest stored_digest;
+		const bool stored = _session_store && _session_store->load(host().to_string(), *_tls_session, stored_digest);
+		_persist_session = false;
+
+		// The portal certificate is always verified by the first connection.
+		set_crt_verification(true);
+
 		try {
 			HttpsClient::connect();
 		}
@@ -76,12 +105,8 @@ namespace fw {
 			attempt to validate it using the CAs stored in the Windows root
 			certificate store.
 		*/
-		int crt_status = get_crt_check();
-
-		if (crt_status & MBEDTLS_X509_BADCERT_NOT_TRUSTED) {
-			if (utl::x509crt_is_trusted(get_peer_crt()))
-				crt_status &= ~MBEDTLS_X509_BADCERT_NOT_TRUSTED;
-		}
+		const CrtDigest peer_crt_digest{ get_peer_crt() };
+		const int crt_status = check_peer_crt(peer_crt_digest);
 
 		if (crt_status == 0) {
 			_logger->info(">> peer X.509 certificate valid");
@@ -105,8 +130,13 @@ namespace fw {
 			Compute the digest of the certificate.
 			This digest is checked during a future reconnection to verify the certificate.
 		*/
-		_peer_crt_digest = CrtDigest(get_peer_crt());
+		_peer_crt_digest = peer_crt_digest;
 
+		// A stored session is bound to the certificate of the firewall.  If the
+		// certificate changed, the stored session is obsolete.
+		if (stored && stored_digest != _peer_crt_digest)
+			_session_store->remove(host().to_string());
+		_persist_session = (crt_status == 0);
 
 		/*
 			Fetch the top page, following up to two redirects if necessary.
@@ -120,6 +150,9 @@ namespace fw {
 			return portal_err::HTTP_ERROR;
 		}
 
+		// A TLS 1.3 ticket has now been received from the firewall.
+		persist_session();
+
 		return portal_err::NONE;
 	}
 
@@ -432,6 +465,9 @@ namespace fw {
 		// Delete all session cookies
 		LOG_DEBUG(_logger, "clear cookie jar 0x%012Ix", PTR_VAL(std::addressof(_cookie_jar)));
 		_cookie_jar.clear();
+		_sslvpn_config = {};
+		persist_session();
+		_tls_session->clear();
 
 		return ok;
 	}
@@ -496,7 +532,8 @@ namespace fw {
 			This call is mandatory because the FortiGate will not provide an IP address otherwise.
 		*/
 		const http::Url vpninfo_url = make_url("/remote/fortisslvpn_xml");
-		if (!send_request(http::Request::GET_VERB, vpninfo_url, "", headers, answer, 0))
+		http::BufferSink xml_sink{ MAX_CONFIG_SIZE };
+		if (!do_request(http::Request::GET_VERB, vpninfo_url, "", headers, answer, &xml_sink))
 		{
 			_logger->error("ERROR: get portal configuration failure");
 			return false;
@@ -507,11 +544,9 @@ namespace fw {
 			return false;
 		}
 
-		const utl::ByteBuffer& body = answer.body();
-		const std::string data(body.cbegin(), body.cend());
-
+		// The XML document is parsed in the buffer that received the body.
 		pugi::xml_document doc;
-		pugi::xml_parse_result parse_result = doc.load_string(data.c_str());
+		pugi::xml_parse_result parse_result = doc.load_buffer_inplace(xml_sink.data(), xml_sink.size());
 
 		if (parse_result.status != pugi::xml_parse_status::status_ok) {
 			_logger->error("ERROR: portal configuration - XML parse error");
@@ -524,12 +559,24 @@ namespace fw {
 			return false;
 		}
 
-		const pugi::xml_attribute& address = root
-			.child("ipv4")
+		const pugi::xml_node& ipv4 = root.child("ipv4");
+		const pugi::xml_attribute& address = ipv4
 			.child("assigned-addr")
 			.attribute("ipv4");
 		sslvpn_config.local_addr = address.as_string();
 
+		sslvpn_config.dns_addrs.clear();
+		for (const pugi::xml_node& dns : ipv4.children("dns")) {
+			const std::string dns_addr = dns.attribute("ip").as_string();
+			if (!dns_addr.empty())
+				sslvpn_config.dns_addrs.push_back(dns_addr);
+		}
+
+		// The tunnel can be opened over DTLS.
+		sslvpn_config.dtls = root.attribute("dtls").as_int() == 1;
+
+		_sslvpn_config = sslvpn_config;
+
 		return true;
 	}
 
@@ -544,28 +591,128 @@ namespace fw {
 	}
 
 
+	void FirewallClient::set_session_store(const utl::Path& path)
+	{
+		DEBUG_ENTER(_logger);
+
+		_session_store = std::make_unique<fw::SessionStore>(path);
+	}
+
+
+	int FirewallClient::check_peer_crt(const CrtDigest& digest)
+	{
+		int crt_status = get_crt_check();
+
+		if (crt_status & MBEDTLS_X509_BADCERT_NOT_TRUSTED) {
+			if (is_crt_verified(digest)) {
+				crt_status &= ~MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+			}
+			else {
+				const uint64_t start_time = utl::now_us();
+				if (utl::x509crt_is_trusted(get_peer_crt()))
+					crt_status &= ~MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+
+				if (crt_status == 0 && _crt_cache)
+					_crt_cache->add(digest, get_peer_crt(), utl::now_us() - start_time);
+			}
+		}
+		else if (crt_status == 0 && _crt_cache) {
+			_crt_cache->add(digest, get_peer_crt(), 0);
+		}
+
+		return crt_status;
+	}
+
+
+	bool FirewallClient::is_crt_verified(const CrtDigest& digest)
+	{
+		uint64_t verify_time = 0;
+
+		if (!_crt_cache || !_crt_cache->find(digest, verify_time))
+			return false;
+
+		LOG_DEBUG(_logger, "certificate verified by a previous connection");
+		_crt_cache_hits++;
+		_crt_time_saved += verify_time;
+
+		return true;
+	}
+
+
+	void FirewallClient::persist_session()
+	{
+		if (_session_store && _persist_session)
+			_session_store->save(host().to_string(), _peer_crt_digest, *_tls_session);
+	}
+
+
 	fw::FirewallTunnel* FirewallClient::create_tunnel(const net::Endpoint& local_ep,
-		const net::Endpoint& remote_ep, const net::tunneler_config& config)
+		const net::Endpoints& remote_eps, const net::tunneler_config& config)
 	{
 		DEBUG_ENTER(_logger);
 
+		net::tunneler_config tunnel_config{ config };
+		if (tunnel_config.ppp.seed_addresses) {
+			tunnel_config.ppp.local_addr = _sslvpn_config.local_addr;
+			tunnel_config.ppp.dns_addrs = _sslvpn_config.dns_addrs;
+		}
+
+		// The tunnel resumes the TLS session of the portal.
+		http::HttpsClientPtr tunnel_socket = std::make_unique<http::HttpsClient>(host(), get_tls_config());
+		tunnel_socket->set_session_cache(_tls_session);
+
+		// The DTLS transport is tried first if the firewall supports it.
+		const net::TlsConfig* const dtls_config = _sslvpn_config.dtls ? _dtls_config : nullptr;
+
+		// The tunnel takes over the portal connection, this client reconnects
+		// if it sends another request.  Otherwise, the certificate chain is not
+		// verified again if it was verified recently, the tunnel compares the
+		// certificate digests.
+		if (tunnel_config.reuse_connection && !tunnel_config.early_listen && !dtls_config &&
+			tunnel_socket->take_over(*this))
+			LOG_DEBUG(_logger, "tunnel reuses the portal connection");
+		else if (is_crt_verified(_peer_crt_digest))
+			tunnel_socket->set_crt_verification(false);
+
 		return new fw::FirewallTunnel(
-			std::make_unique<http::HttpsClient>(host(), get_tls_config()),
+			std::move(tunnel_socket),
 			local_ep,
-			remote_ep,
-			config,
-			_cookie_jar
+			remote_eps,
+			tunnel_config,
+			_cookie_jar,
+			dtls_config,
+			_peer_crt_digest
 		);
 	}
 
 
-	bool FirewallClient::send_and_receive(http::Request& request, http::Answer& answer)
+	void FirewallClient::set_dtls_config(const net::TlsConfig* config)
+	{
+		DEBUG_ENTER(_logger);
+
+		_dtls_config = config;
+	}
+
+
+	void FirewallClient::set_crt_cache(fw::CrtCache* cache)
+	{
+		DEBUG_ENTER(_logger);
+
+		_crt_cache = cache;
+	}
+
+
+	bool FirewallClient::send_and_receive(http::Request& request, http::Answer& answer, http::BodySink* sink)
 	{
 		DEBUG_ENTER(_logger);
 
 		if (is_reconnection_required()) {
 			disconnect();
 
+			// The chain of a certificate verified recently is not verified
+			// again, the digest check below is sufficient.
+			set_crt_verification(!is_crt_verified(_peer_crt_digest));
+
 			try {
 				connect();
 			}
@@ -591,6 +738,9 @@ namespace fw {
 				certificate on subsequent reconnects. This provides the necessary security check
 				(detecting any certificate or man-in-the-middle changes) while avoiding redundant
 				and costly full-chain validation operations.
+
+				When the TLS session is resumed, the certificate is the one saved with the
+				session and the same check applies.
 			*/
 			if (_peer_crt_digest != CrtDigest(get_peer_crt())) {
 				_logger->error("ERROR: invalid certificate digest");
@@ -610,7 +760,7 @@ namespace fw {
 		}
 
 		try {
-			recv_answer(answer);
+			recv_answer(answer, sink);
 		}
 		catch (const std::runtime_error& e) {
 			_logger->error("ERROR: failed to receive HTTP data from %s", host().to_string().c_str());
@@ -624,7 +774,8 @@ namespace fw {
 
 
 	bool FirewallClient::do_request(const std::string& verb, const http::Url& url,
-		const std::string& body, const http::Headers& headers, http::Answer& answer)
+		const std::string& body, const http::Headers& headers, http::Answer& answer,
+		http::BodySink* sink)
 	{
 		DEBUG_ENTER(_logger);
 		
@@ -643,7 +794,7 @@ namespace fw {
 		request.set_body(reinterpret_cast<const unsigned char*>(body.c_str()), body.length());
 
 		// Send and wait for a response
-		const bool success = FirewallClient::send_and_receive(request, answer);
+		const bool success = FirewallClient::send_and_receive(request, answer, sink);
 		if (!success) {
 			disconnect();
 		}
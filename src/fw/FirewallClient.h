@@ -9,6 +9,7 @@
 
 #include <functional>
 #include <string>
+#include <vector>
 #include <mbedtls/x509_crt.h>
 #include "fw/AuthTypes.h"
 #include "http/HttpsClient.h"
@@ -17,9 +18,12 @@
 #include "http/Url.h"
 #include "http/Request.h"
 #include "http/Headers.h"
+#include "fw/CrtCache.h"
 #include "fw/CrtDigest.h"
 #include "fw/FirewallTunnel.h"
+#include "fw/SessionStore.h"
 #include "net/Endpoint.h"
+#include "net/TlsSession.h"
 #include "util/Mutex.h"
 #include "util/StringMap.h"
 
@@ -39,6 +43,8 @@ namespace fw {
 	struct SslvpnConfig
 	{
 		std::string local_addr;		// IP address assigned to this client.
+		std::vector<std::string> dns_addrs;	// DNS servers pushed by the firewall.
+		bool dtls = false;			// The firewall accepts a DTLS tunnel.
 	};
 
 
@@ -160,9 +166,11 @@ namespace fw {
 		 * This function makes an authenticated send_request to the portal server to fetch the
 		 * SSL VPN configuration in XML format. It is mandatory to obtain this configuration
 		 * to get the IP address from the FortiGate device. If the send_request is successful,
-		 * the local address (IPv4) is extracted and stored in the provided `SslvpnConfig`
-		 * object. If the client is not authenticated or if there are issues with the
-		 * send_request or XML parsing, the function returns `false`.
+		 * the local address (IPv4) and the DNS servers are extracted and stored in the
+		 * provided `SslvpnConfig` object. The configuration is also kept by this client
+		 * to pre-seed the PPP negotiation of the tunnels. If the client is not
+		 * authenticated or if there are issues with the send_request or XML parsing,
+		 * the function returns `false`.
 		 *
 		 * @param sslvpn_config The object to store the SSL VPN configuration, particularly
 		 *                      the assigned local IPv4 address.
@@ -180,14 +188,16 @@ namespace fw {
 		 * between the specified local and remote endpoints. However, the tunnel
 		 * is not established upon creation. The caller must explicitly invoke
 		 * `connect()` on the returned tunnel object to establish the connection.
+		 * If enabled in the configuration, the addresses retrieved by `get_config()`
+		 * are used to pre-seed the PPP negotiation.
 		 *
 		 * @param local_ep The local network endpoint for the tunnel.
-		 * @param remote_ep The remote network endpoint to which traffic is forwarded.
+		 * @param remote_eps The remote network endpoints to which traffic is forwarded.
 		 * @param config The configuration parameters for the tunneler.
 		 * @return A pointer to the allocated FirewallTunnel instance, or nullptr if
 		 *         the tunnel could not be created.
 		 */
-		fw::FirewallTunnel* create_tunnel(const net::Endpoint& local_ep, const net::Endpoint& remote_ep,
+		fw::FirewallTunnel* create_tunnel(const net::Endpoint& local_ep, const net::Endpoints& remote_eps,
 			const net::tunneler_config& config);
 
 		/**
@@ -195,6 +205,37 @@ namespace fw {
 		*/
 		bool is_authenticated() const;
 
+		/**
+		 * Enables the persistent TLS session store.
+		 *
+		 * The session saved by a previous execution is resumed by the first
+		 * connection to the portal.  The store must be configured before
+		 * calling open.
+		 *
+		 * @param path The path of the store.
+		*/
+		void set_session_store(const utl::Path& path);
+
+		/**
+		 * Enables the DTLS tunnels.
+		 *
+		 * The tunnels created by this client are opened over DTLS if the
+		 * firewall supports it, they fall back to TLS otherwise.
+		 *
+		 * @param config The DTLS configuration, nullptr disables DTLS.
+		*/
+		void set_dtls_config(const net::TlsConfig* config);
+
+		/**
+		 * Defines the cache of the verified certificates.
+		 *
+		 * The connections to a firewall presenting a certificate found in the
+		 * cache skip the verification of the certificate chain.
+		 *
+		 * @param cache The cache, nullptr disables the cache.
+		*/
+		void set_crt_cache(fw::CrtCache* cache);
+
 	private:
 		// The class name
 		static const char* __class__;
@@ -205,21 +246,56 @@ namespace fw {
 		// Session cookies.
 		http::Cookies _cookie_jar;
 
+		// The last SSL VPN configuration retrieved from the portal.
+		fw::SslvpnConfig _sslvpn_config;
+
+		// The TLS session resumed by the portal reconnections and the tunnels.
+		const net::TlsSessionPtr _tls_session;
+
+		// The persistent session store or nullptr if disabled.
+		std::unique_ptr<fw::SessionStore> _session_store;
+
+		// The DTLS configuration or nullptr if DTLS is disabled.
+		const net::TlsConfig* _dtls_config;
+
+		// The cache of the verified certificates or nullptr if disabled.
+		fw::CrtCache* _crt_cache;
+
+		// Verifications avoided by the certificate cache and the time saved (us).
+		uint32_t _crt_cache_hits;
+		uint64_t _crt_time_saved;
+
+		// True if the TLS session can be saved in the persistent store.  Only the
+		// sessions established with a trusted certificate are saved.
+		bool _persist_session;
+
 		// Mutex to serialize calls.
 		utl::Mutex _mutex;
 
 		// The fortiGate realm.
 		const std::string _realm;
 
+		// Saves the current TLS session in the persistent store.
+		void persist_session();
+
+		// Returns the verification status of the peer certificate, the
+		// certificate is verified against the Windows certificate store if
+		// it is not trusted by mbedtls.
+		int check_peer_crt(const CrtDigest& digest);
+
+		// Returns true if the certificate was verified by a previous connection.
+		bool is_crt_verified(const CrtDigest& digest);
+
 		// Logs an HTTP error message.
 		void log_http_error(const char* msg, const http::Answer& answer);
 
-		// Sends a send_request and wait for a response.
-		bool send_and_receive(http::Request& request, http::Answer& answer);
+		// Sends a send_request and wait for a response.  The body of the response
+		// is passed to the sink if specified, otherwise it is stored in the answer.
+		bool send_and_receive(http::Request& request, http::Answer& answer, http::BodySink* sink = nullptr);
 
 		// Sends a send_request and wait for a response.
 		bool do_request(const std::string& verb, const http::Url& url, const std::string& body,
-			const http::Headers& headers, http::Answer& answer);
+			const http::Headers& headers, http::Answer& answer, http::BodySink* sink = nullptr);
 
 		// Sends a send_request and wait for a response, follows redirect if allow_redir is >= 0.
 		// allow_redir specifies the number of allowed redirection.
@@ -7,19 +7,38 @@
 */
 #include "FirewallTunnel.h"
 #include "util/Logger.h"
+#include <cstring>
 #include <stdexcept>
+#include <string>
+#include <vector>
+#include <mbedtls/platform_util.h>
 
 
 namespace fw {
+	using namespace utl;
+
+	// Maximum time (in ms) allowed to open the DTLS tunnel.
+	static constexpr uint32_t DTLS_OPEN_TIMEOUT = 5000;
+
+	// Hello messages exchanged over DTLS before the PPP frames.  Each message
+	// is preceded by its length (including the length field) in big endian,
+	// the fields are separated by a nul character.
+	static const char DTLS_CLIENT_HELLO[] = "GFtype\0clthello\0SVPNCOOKIE";
+	static const char DTLS_SERVER_HELLO[] = "GFtype\0svrhello\0handshake";
+	static const char DTLS_HELLO_OK[] = "ok";
+
 
 	FirewallTunnel::FirewallTunnel(http::HttpsClientPtr tunnel_socket,
-		const net::Endpoint& local_ep, const net::Endpoint& remote_ep,
-		const net::tunneler_config& config, const http::Cookies& cookie_jar
+		const net::Endpoint& local_ep, const net::Endpoints& remote_eps,
+		const net::tunneler_config& config, const http::Cookies& cookie_jar,
+		const net::TlsConfig* dtls_config, const CrtDigest& crt_digest
 	) :
-		net::Tunneler(*tunnel_socket, local_ep, remote_ep, config),
+		net::Tunneler(*tunnel_socket, local_ep, remote_eps, config),
 		_logger(utl::Logger::get_logger()),
 		_tunnel_socket{ std::move(tunnel_socket) },
-		_cookie_jar{ cookie_jar }
+		_cookie_jar{ cookie_jar },
+		_dtls_socket{ dtls_config ? std::make_unique<net::TlsSocket>(*dtls_config) : nullptr },
+		_crt_digest{ crt_digest }
 	{
 		DEBUG_CTOR(_logger);
 	}
@@ -35,8 +54,42 @@ namespace fw {
 	{
 		DEBUG_ENTER(_logger);
 
+		// In early listen mode, the tunnel is opened by the tunneler thread
+		// while local clients are already accepted.
+		if (!config().early_listen && !open_tunnel())
+			return false;
+
+		// start the thread
+		return net::Tunneler::start();
+	}
+
+
+	bool FirewallTunnel::open_tunnel()
+	{
+		DEBUG_ENTER(_logger);
+
+		if (_dtls_socket) {
+			if (open_dtls_tunnel()) {
+				_logger->info(">> tunnel opened over DTLS");
+				set_tunnel(*_dtls_socket);
+				return true;
+			}
+
+			_logger->info(">> DTLS tunnel not available, using TLS");
+			_dtls_socket->shutdown();
+		}
+
 		try {
-			_tunnel_socket->connect();
+			// The socket may hold the connection of the portal.
+			if (!_tunnel_socket->is_connected()) {
+				_tunnel_socket->connect();
+
+				// The tunnel must be connected to the portal authenticated by the user.
+				if (CrtDigest(_tunnel_socket->get_peer_crt()) != _crt_digest) {
+					_logger->error("ERROR: tunnel certificate differs from the portal certificate");
+					return false;
+				}
+			}
 			start_tunnel_mode();
 		}
 		catch (const std::runtime_error& e) {
@@ -46,8 +99,76 @@ namespace fw {
 			return false;
 		}
 
-		// start the thread
-		return net::Tunneler::start();
+		return true;
+	}
+
+
+	bool FirewallTunnel::open_dtls_tunnel()
+	{
+		DEBUG_ENTER(_logger);
+
+		if (!_cookie_jar.exists("SVPNCOOKIE"))
+			return false;
+
+		const utl::Timer timer{ DTLS_OPEN_TIMEOUT };
+		mbed_err rc = _dtls_socket->connect(_tunnel_socket->host(), timer);
+		if (rc == 0) {
+			const net::tls_handshake_status status = _dtls_socket->handshake(timer);
+			if (status.status_code != net::hdk_status_code::SSLCTX_HDK_OK)
+				rc = status.rc;
+		}
+
+		if (rc) {
+			LOG_DEBUG(_logger, "DTLS connect failure rc=%d", rc);
+			return false;
+		}
+
+		// The DTLS server must be the portal authenticated by the user.
+		if (CrtDigest(_dtls_socket->get_peer_crt()) != _crt_digest) {
+			_logger->error("ERROR: DTLS certificate differs from the portal certificate");
+			return false;
+		}
+
+		// Send the client hello with the session cookie.
+		const std::string cookie{ _cookie_jar.get("SVPNCOOKIE").get_value().uncrypt() };
+		std::vector<unsigned char> hello(2);
+		hello.insert(hello.end(), DTLS_CLIENT_HELLO, DTLS_CLIENT_HELLO + sizeof(DTLS_CLIENT_HELLO));
+		hello.insert(hello.end(), cookie.cbegin(), cookie.cend());
+		hello.push_back(0);
+		hello[0] = static_cast<unsigned char>(hello.size() >> 8);
+		hello[1] = static_cast<unsigned char>(hello.size() & 0xFF);
+
+		const net::snd_status snd_status = _dtls_socket->write(hello.data(), hello.size(), timer);
+		::mbedtls_platform_zeroize(hello.data(), hello.size());
+		if (snd_status.code != net::snd_status_code::NETCTX_SND_OK) {
+			LOG_DEBUG(_logger, "DTLS hello send failure rc=%d", snd_status.rc);
+			return false;
+		}
+
+		// Wait for the server hello.
+		unsigned char buffer[256] = { 0 };
+		net::rcv_status rcv_status = _dtls_socket->read(buffer, 2, timer);
+		const size_t length = (static_cast<size_t>(buffer[0]) << 8) | buffer[1];
+		if (rcv_status.code == net::rcv_status_code::NETCTX_RCV_OK) {
+			if (length <= 2 || length > sizeof(buffer))
+				return false;
+
+			rcv_status = _dtls_socket->read(buffer + 2, length - 2, timer);
+		}
+
+		if (rcv_status.code != net::rcv_status_code::NETCTX_RCV_OK) {
+			LOG_DEBUG(_logger, "DTLS hello receive failure code=%d rc=%d", rcv_status.code, rcv_status.rc);
+			return false;
+		}
+
+		const size_t expected = 2 + sizeof(DTLS_SERVER_HELLO) + sizeof(DTLS_HELLO_OK);
+		const bool accepted = length >= expected &&
+			std::memcmp(buffer + 2, DTLS_SERVER_HELLO, sizeof(DTLS_SERVER_HELLO)) == 0 &&
+			std::memcmp(buffer + 2 + sizeof(DTLS_SERVER_HELLO), DTLS_HELLO_OK, sizeof(DTLS_HELLO_OK)) == 0;
+		if (!accepted)
+			LOG_DEBUG(_logger, "DTLS tunnel rejected by the firewall");
+
+		return accepted;
 	}
 
 
@@ -7,9 +7,13 @@
 */
 #pragma once
 
+#include <memory>
+#include "fw/CrtDigest.h"
 #include "http/HttpsClient.h"
 #include "http/Cookies.h"
 #include "net/Endpoint.h"
+#include "net/TlsConfig.h"
+#include "net/TlsSocket.h"
 #include "net/Tunneler.h"
 
 
@@ -22,16 +26,20 @@ namespace fw {
 		* Creates a Firewall tunnel instance.
 		*
 		* The Tunnel forwards traffic received on the specified local endpoint
-		* to the remote endpoint through a secure, encrypted tunnel.
+		* to one of the remote endpoints through a secure, encrypted tunnel.
 		*
 		* @param tunnel_socket  The TLS socket used for secure communication.
 		* @param local  The local network endpoint to listen for incoming traffic.
-		* @param remote  The remote network endpoint to forward traffic to.
+		* @param remotes  The remote network endpoints to forward traffic to.
 		* @param config  Configuration settings for the tunneler.
 		* @param cookie_jar Session cookies
+		* @param dtls_config  The DTLS configuration or nullptr to use only the TLS socket.
+		* @param crt_digest  The digest of the certificate presented by the portal,
+		*                    the DTLS server must present the same certificate.
 		*/
 		FirewallTunnel(http::HttpsClientPtr tunnel_socket, const net::Endpoint& local_ep,
-			const net::Endpoint& remote_ep, const net::tunneler_config& config, const http::Cookies& cookie_jar);
+			const net::Endpoints& remote_eps, const net::tunneler_config& config, const http::Cookies& cookie_jar,
+			const net::TlsConfig* dtls_config = nullptr, const CrtDigest& crt_digest = CrtDigest());
 		~FirewallTunnel() override;
 
 
@@ -39,9 +47,20 @@ namespace fw {
 		 * Starts the tunneler.
 		 * 
 		 * The function opens an encrypted TLS socket and starts the tunnel.
+		 * In early listen mode, the socket is opened by the tunneler thread.
 		 */
 		bool start() override;
 
+	protected:
+		/**
+		 * Opens the encrypted TLS socket and sends the tunnel request.
+		 *
+		 * When a DTLS configuration is specified, the tunnel is first opened
+		 * over DTLS.  The TLS socket is used if the firewall does not answer
+		 * or rejects the DTLS tunnel.
+		 */
+		bool open_tunnel() override;
+
 	private:
 		// The class name
 		static const char* __class__;
@@ -55,6 +74,16 @@ namespace fw {
 		// The application cookie jar
 		const http::Cookies& _cookie_jar;
 
+		// The DTLS socket or nullptr if DTLS is disabled.
+		const std::unique_ptr<net::TlsSocket> _dtls_socket;
+
+		// The digest of the portal certificate.
+		const CrtDigest _crt_digest;
+
+		/* Opens the DTLS socket and exchanges the tunnel hello messages.
+		*/
+		bool open_dtls_tunnel();
+
 		/* Starts the tunnel mode.
 		 *
 		 * The function initiates the tunnel mode by sending the appropriate URL
@@ -0,0 +1,317 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "SessionStore.h"
+
+#include <Windows.h>
+#include <wincrypt.h>
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <mbedtls/platform_util.h>
+#include "util/StrUtil.h"
+
+
+namespace fw {
+	using namespace utl;
+
+	// A session without ticket is kept 1 hour, a ticket never more than the 7 days
+	// allowed by RFC 8446.
+	static constexpr uint64_t DEFAULT_LIFETIME = 60 * 60;
+	static constexpr uint64_t MAX_LIFETIME = 7 * 24 * 60 * 60;
+
+	// Limits of the store.
+	static constexpr size_t MAX_ENTRIES = 16;
+	static constexpr LONGLONG MAX_FILE_SIZE = 1024 * 1024;
+
+	// Header of the decrypted store.
+	static const unsigned char STORE_MAGIC[4] = { 'F', 'R', 'S', '1' };
+
+
+	static void put_uint(std::vector<unsigned char>& buffer, uint64_t value, size_t size)
+	{
+		for (size_t i = 0; i < size; i++)
+			buffer.push_back(static_cast<unsigned char>(value >> (8 * i)));
+	}
+
+
+	static void put_bytes(std::vector<unsigned char>& buffer, const unsigned char* data, size_t size)
+	{
+		buffer.insert(buffer.end(), data, data + size);
+	}
+
+
+	static bool get_uint(const unsigned char*& p, const unsigned char* end, uint64_t& value, size_t size)
+	{
+		if (static_cast<size_t>(end - p) < size)
+			return false;
+
+		value = 0;
+		for (size_t i = 0; i < size; i++)
+			value |= static_cast<uint64_t>(p[i]) << (8 * i);
+		p += size;
+
+		return true;
+	}
+
+
+	static bool get_bytes(const unsigned char*& p, const unsigned char* end, unsigned char* data, size_t size)
+	{
+		if (static_cast<size_t>(end - p) < size)
+			return false;
+
+		std::memcpy(data, p, size);
+		p += size;
+
+		return true;
+	}
+
+
+	SessionStore::SessionStore(const utl::Path& path) :
+		_logger(Logger::get_logger()),
+		_path(path)
+	{
+		DEBUG_CTOR(_logger);
+	}
+
+
+	SessionStore::~SessionStore()
+	{
+		DEBUG_DTOR(_logger);
+	}
+
+
+	bool SessionStore::load(const std::string& host, net::TlsSession& session, CrtDigest& digest)
+	{
+		DEBUG_ENTER_FMT(_logger, "host=%s", host.c_str());
+
+		std::vector<entry> entries;
+		if (!read_entries(entries))
+			return false;
+
+		auto it = std::find_if(entries.begin(), entries.end(),
+			[&host](const entry& e) { return e.host.compare(host) == 0; });
+		if (it == entries.end())
+			return false;
+
+		const auto version = static_cast<mbedtls_ssl_protocol_version>(it->version);
+		const mbed_err rc = session.deserialize(it->session, host, version);
+		if (rc == 0)
+			digest = CrtDigest(it->digest);
+
+		// A TLS 1.3 ticket is used only once, an invalid entry is useless.
+		if (rc != 0 || version == MBEDTLS_SSL_VERSION_TLS1_3) {
+			::mbedtls_platform_zeroize(it->session.data(), it->session.size());
+			entries.erase(it);
+			write_entries(entries);
+		}
+
+		for (entry& e : entries)
+			::mbedtls_platform_zeroize(e.session.data(), e.session.size());
+
+		return rc == 0;
+	}
+
+
+	bool SessionStore::save(const std::string& host, const CrtDigest& digest, net::TlsSession& session)
+	{
+		DEBUG_ENTER_FMT(_logger, "host=%s", host.c_str());
+
+		entry new_entry;
+		std::string hostname;
+		mbedtls_ssl_protocol_version version;
+		uint32_t lifetime;
+
+		if (session.serialize(new_entry.session, hostname, version, lifetime) != 0 || hostname.compare(host) != 0)
+			return false;
+
+		new_entry.host = host;
+		std::memcpy(new_entry.digest, digest.data(), CrtDigest::DIGEST_SIZE);
+		new_entry.expires = static_cast<uint64_t>(std::time(nullptr)) +
+			std::min(lifetime > 0 ? lifetime : DEFAULT_LIFETIME, MAX_LIFETIME);
+		new_entry.version = static_cast<uint16_t>(version);
+
+		// Replace the entry of this host, the most recent entries are kept.
+		std::vector<entry> entries;
+		read_entries(entries);
+		entries.erase(
+			std::remove_if(entries.begin(), entries.end(), [&host](const entry& e) { return e.host.compare(host) == 0; }),
+			entries.end());
+		if (entries.size() >= MAX_ENTRIES)
+			entries.erase(entries.begin(), entries.begin() + (entries.size() - MAX_ENTRIES + 1));
+		entries.push_back(std::move(new_entry));
+
+		const bool saved = write_entries(entries);
+
+		for (entry& e : entries)
+			::mbedtls_platform_zeroize(e.session.data(), e.session.size());
+
+		return saved;
+	}
+
+
+	void SessionStore::remove(const std::string& host)
+	{
+		DEBUG_ENTER_FMT(_logger, "host=%s", host.c_str());
+
+		std::vector<entry> entries;
+		if (!read_entries(entries))
+			return;
+
+		const size_t count = entries.size();
+		entries.erase(
+			std::remove_if(entries.begin(), entries.end(), [&host](const entry& e) { return e.host.compare(host) == 0; }),
+			entries.end());
+
+		if (entries.size() != count)
+			write_entries(entries);
+
+		for (entry& e : entries)
+			::mbedtls_platform_zeroize(e.session.data(), e.session.size());
+	}
+
+
+	bool SessionStore::read_entries(std::vector<entry>& entries) const
+	{
+		entries.clear();
+
+		// The store is mapped in memory and decrypted in place.
+		const HANDLE file = ::CreateFileW(_path.to_string().c_str(), GENERIC_READ, FILE_SHARE_READ,
+			nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER file_size;
+		if (!::GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0 || file_size.QuadPart > MAX_FILE_SIZE) {
+			::CloseHandle(file);
+			return false;
+		}
+
+		DATA_BLOB plain{ 0, nullptr };
+		bool decrypted = false;
+
+		const HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping) {
+			const LPVOID view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+			if (view) {
+				DATA_BLOB encrypted{ static_cast<DWORD>(file_size.QuadPart), static_cast<BYTE*>(view) };
+				decrypted = ::CryptUnprotectData(&encrypted, nullptr, nullptr, nullptr, nullptr,
+					CRYPTPROTECT_UI_FORBIDDEN, &plain) != FALSE;
+				::UnmapViewOfFile(view);
+			}
+			::CloseHandle(mapping);
+		}
+		::CloseHandle(file);
+
+		if (!decrypted) {
+			_logger->debug("... %s unable to decrypt the session store", __class__);
+			return false;
+		}
+
+		const unsigned char* p = plain.pbData;
+		const unsigned char* const end = plain.pbData + plain.cbData;
+		const uint64_t now = static_cast<uint64_t>(std::time(nullptr));
+		unsigned char magic[sizeof(STORE_MAGIC)];
+		uint64_t count = 0;
+
+		bool valid = get_bytes(p, end, magic, sizeof(magic)) &&
+			std::memcmp(magic, STORE_MAGIC, sizeof(magic)) == 0 &&
+			get_uint(p, end, count, 4) &&
+			count <= MAX_ENTRIES;
+
+		for (uint64_t i = 0; valid && i < count; i++) {
+			entry e;
+			uint64_t host_len, version, session_len;
+
+			valid = get_uint(p, end, host_len, 2) && static_cast<size_t>(end - p) >= host_len;
+			if (valid) {
+				e.host.assign(reinterpret_cast<const char*>(p), static_cast<size_t>(host_len));
+				p += host_len;
+
+				valid = get_bytes(p, end, e.digest, sizeof(e.digest)) &&
+					get_uint(p, end, e.expires, 8) &&
+					get_uint(p, end, version, 2) &&
+					get_uint(p, end, session_len, 4) &&
+					static_cast<size_t>(end - p) >= session_len;
+			}
+
+			if (valid) {
+				e.version = static_cast<uint16_t>(version);
+				e.session.assign(p, p + session_len);
+				p += session_len;
+
+				if (e.expires > now)
+					entries.push_back(std::move(e));
+			}
+		}
+
+		::mbedtls_platform_zeroize(plain.pbData, plain.cbData);
+		::LocalFree(plain.pbData);
+
+		if (!valid) {
+			_logger->debug("... %s invalid session store", __class__);
+			entries.clear();
+		}
+
+		return valid;
+	}
+
+
+	bool SessionStore::write_entries(const std::vector<entry>& entries) const
+	{
+		std::vector<unsigned char> buffer;
+
+		put_bytes(buffer, STORE_MAGIC, sizeof(STORE_MAGIC));
+		put_uint(buffer, entries.size(), 4);
+		for (const entry& e : entries) {
+			put_uint(buffer, e.host.size(), 2);
+			put_bytes(buffer, reinterpret_cast<const unsigned char*>(e.host.data()), e.host.size());
+			put_bytes(buffer, e.digest, sizeof(e.digest));
+			put_uint(buffer, e.expires, 8);
+			put_uint(buffer, e.version, 2);
+			put_uint(buffer, e.session.size(), 4);
+			put_bytes(buffer, e.session.data(), e.session.size());
+		}
+
+		DATA_BLOB plain{ static_cast<DWORD>(buffer.size()), buffer.data() };
+		DATA_BLOB encrypted{ 0, nullptr };
+		const bool encrypted_ok = ::CryptProtectData(&plain, L"FortiRDP TLS sessions", nullptr, nullptr, nullptr,
+			CRYPTPROTECT_UI_FORBIDDEN, &encrypted) != FALSE;
+		::mbedtls_platform_zeroize(buffer.data(), buffer.size());
+
+		if (!encrypted_ok) {
+			_logger->error("ERROR: unable to encrypt the TLS session store (%lu)", ::GetLastError());
+			return false;
+		}
+
+		// The store is replaced atomically.
+		::CreateDirectoryW(_path.folder().c_str(), nullptr);
+		const std::wstring tmp_path = _path.to_string() + L".tmp";
+		bool written = false;
+		{
+			std::ofstream ofs{ tmp_path, std::ios::out | std::ios::binary | std::ios::trunc };
+			ofs.write(reinterpret_cast<const char*>(encrypted.pbData), encrypted.cbData);
+			written = ofs.good();
+		}
+		::LocalFree(encrypted.pbData);
+
+		if (written)
+			written = ::MoveFileExW(tmp_path.c_str(), _path.to_string().c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+
+		if (!written) {
+			_logger->error("ERROR: unable to write the TLS session store %s",
+				utl::str::wstr2str(_path.compact(64)).c_str());
+			::DeleteFileW(tmp_path.c_str());
+		}
+
+		return written;
+	}
+
+
+	const char* SessionStore::__class__ = "SessionStore";
+}
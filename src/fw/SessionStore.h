@@ -0,0 +1,98 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "fw/CrtDigest.h"
+#include "net/TlsSession.h"
+#include "util/Logger.h"
+#include "util/Path.h"
+
+
+namespace fw {
+
+	/**
+	* SessionStore: a file that keeps the TLS sessions established with the
+	* firewalls so that they can be resumed after a restart of the application.
+	*
+	* Each entry is keyed by the firewall host and holds the digest of the
+	* certificate presented when the session was established.  Entries expire
+	* according to the ticket lifetime announced by the server.  A TLS 1.3
+	* entry is removed as soon as it is loaded, a ticket is used only once.
+	*
+	* A serialized session contains the master secret of the connection. The
+	* file is encrypted with the Windows data protection API, only the current
+	* user can decrypt it.
+	*/
+	class SessionStore final
+	{
+	public:
+		/**
+		 * Creates a session store.
+		 *
+		 * @param path The path of the store, the file is created when a
+		 *             session is saved.
+		*/
+		explicit SessionStore(const utl::Path& path);
+		~SessionStore();
+
+		/**
+		 * Loads the session saved for a host.
+		 *
+		 * @param host    The firewall host.
+		 * @param session The session that receives the saved session.
+		 * @param digest  The digest of the certificate of the saved session.
+		 *
+		 * @return true if a valid session was found.
+		*/
+		bool load(const std::string& host, net::TlsSession& session, CrtDigest& digest);
+
+		/**
+		 * Saves the session established with a host.
+		 *
+		 * @param host    The firewall host.
+		 * @param digest  The digest of the certificate presented by the host.
+		 * @param session The session to save.
+		 *
+		 * @return true if the session is saved.
+		*/
+		bool save(const std::string& host, const CrtDigest& digest, net::TlsSession& session);
+
+		/**
+		 * Removes the session saved for a host.
+		*/
+		void remove(const std::string& host);
+
+	private:
+		// The class name
+		static const char* __class__;
+
+		// A reference to the application logger.
+		utl::Logger* const _logger;
+
+		// The path of the store.
+		const utl::Path _path;
+
+		struct entry {
+			std::string host;
+			unsigned char digest[CrtDigest::DIGEST_SIZE];
+			uint64_t expires;				// expiration time (s since the epoch)
+			uint16_t version;				// mbedtls_ssl_protocol_version
+			std::vector<unsigned char> session;
+		};
+
+		// Reads and decrypts all entries, the expired entries are skipped.
+		bool read_entries(std::vector<entry>& entries) const;
+
+		// Encrypts and writes all entries.
+		bool write_entries(const std::vector<entry>& entries) const;
+	};
+
+}
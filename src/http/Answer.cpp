@@ -8,6 +8,8 @@
 #include "Answer.h"
 
 #include <algorithm>
+#include <climits>
+#include <memory>
 #include <string>
 #include <zlib.h>
 #include "http/Cookie.h"
@@ -29,6 +31,36 @@ namespace http {
 	const int default_code = 400;
 	const std::string default_reason = "Bad Request";
 
+
+	/**
+	* BodyBuffer: the default sink that stores the body in the answer.
+	*
+	* The bytes received above the maximum size are discarded.
+	*/
+	class BodyBuffer final : public BodySink
+	{
+	public:
+		BodyBuffer(ByteBuffer& body, size_t max_size) :
+			_body(body),
+			_max_size(max_size)
+		{
+		}
+
+		bool write(const unsigned char* data, size_t len) override
+		{
+			// append what we can in the buffer
+			if (_body.size() < _max_size)
+				_body.append(data, std::min(len, _max_size - _body.size()));
+
+			return true;
+		}
+
+	private:
+		ByteBuffer& _body;
+		const size_t _max_size;
+	};
+
+
 	Answer::Answer() :
 		_logger(Logger::get_logger()),
 		_status_code(default_code),
@@ -54,12 +86,12 @@ namespace http {
 		_status_code = default_code;
 		_reason_phrase = default_reason;
 		_body.clear();
-		_headers.serase();
+		_headers.clear();
 		_cookies.clear();
 	}
 
 
-	bool Answer::read_buffer(net::TcpSocket& socket, unsigned char* buffer, const size_t len, const utl::Timer& timer)
+	bool Answer::read_buffer(RecvBuffer& input, unsigned char* buffer, const size_t len, const utl::Timer& timer)
 	{
 		TRACE_ENTER_FMT(_logger, "buffer=0x%012Ix size=%zu timeout=%lu",
 			PTR_VAL(buffer),
@@ -67,30 +99,11 @@ namespace http {
 			timer.remaining_time()
 		);
 
-		const rcv_status status{ socket.read(buffer, len, timer) };
-		switch (status.code) {
-			case rcv_status_code::NETCTX_RCV_ERROR:
-			case rcv_status_code::NETCTX_RCV_RETRY:
-				// read failed or timed out
-				throw mbed_error(status.rc);
-
-			case rcv_status_code::NETCTX_RCV_OK:
-				return true;
-
-			case rcv_status_code::NETCTX_RCV_EOF:
-			default:
-				return false;
-		}
-	}
-
-
-	bool Answer::read_byte(net::TcpSocket& socket, unsigned char& c, const utl::Timer& timer)
-	{
-		return read_buffer(socket, &c, sizeof(char), timer);
+		return input.read(buffer, len, timer);
 	}
 
 
-	Answer::answer_status Answer::read_line(net::TcpSocket& socket, utl::ByteBuffer& buffer, const utl::Timer& timer)
+	Answer::answer_status Answer::read_line(RecvBuffer& input, utl::ByteBuffer& buffer, const utl::Timer& timer)
 	{
 		TRACE_ENTER_FMT(_logger, "buffer=0x%012Ix size=%zu timeout=%lu",
 			PTR_VAL(std::addressof(buffer)),
@@ -98,46 +111,11 @@ namespace http {
 			timer.remaining_time()
 		);
 
-		int state = 0;
-		size_t bytes_received = 0;
-
-		buffer.clear();
-
-		while (state != 2) {
-			unsigned char c;
-
-			if (!read_byte(socket, c, timer))
-				return answer_status::ERR_EOF;
-
-			switch (state) {
-			case 0:
-				if (c == '\r')
-					state = 1;
-				else if (bytes_received < buffer.capactity())
-					buffer.append(&c, 1);
-				break;
-
-			case 1:
-				if (c == '\n')
-					state = 2;
-				else if (bytes_received < buffer.capactity()) {
-					buffer.append('\r');
-					buffer.append(c);
-				}
-				break;
-
-			default:
-				break;
-			}
-
-			bytes_received++;
-		}
-
-		return answer_status::ERR_NONE;
+		return input.read_line(buffer, buffer.capactity(), timer) ? answer_status::ERR_NONE : answer_status::ERR_EOF;
 	}
 
 
-	Answer::answer_status Answer::read_control_data(net::TcpSocket& socket, const utl::Timer& timer)
+	Answer::answer_status Answer::read_control_data(RecvBuffer& input, const utl::Timer& timer)
 	{
 		DEBUG_ENTER(_logger);
 
@@ -152,21 +130,21 @@ namespace http {
 		// Read the HTTP version. Return an error code if the server has closed 
 		// the connection before sending a valid response.
 		std::array<unsigned char, 8> http_version = {};
-		if (!read_buffer(socket, http_version.data(), http_version.size(), timer))
+		if (!read_buffer(input, http_version.data(), http_version.size(), timer))
 			return answer_status::ERR_INVALID_STATUS_LINE;
 		if (std::memcmp(http_version.data(), "HTTP/1.1", http_version.size()) != 0)
 			return answer_status::ERR_INVALID_VERSION;
 
 		// Skip a space
 		unsigned char space;
-		if (!read_buffer(socket, &space, sizeof(space), timer) || space != ' ')
+		if (!read_buffer(input, &space, sizeof(space), timer) || space != ' ')
 			return answer_status::ERR_INVALID_STATUS_LINE;
 
 		// Read the status code.
 		// The status code of a response is a three-digit integer code that describes
 		// the result of the send_request.
 		std::array<unsigned char, 3> status_code = {};
-		if (!read_buffer(socket, status_code.data(), status_code.size(), timer))
+		if (!read_buffer(input, status_code.data(), status_code.size(), timer))
 			return answer_status::ERR_INVALID_STATUS_LINE;
 
 		// Convert status code text to an integer.
@@ -183,7 +161,7 @@ namespace http {
 
 		// Read the reason phrase
 		ByteBuffer buffer(1024);
-		answer_status status = read_line(socket, buffer, timer);
+		answer_status status = read_line(input, buffer, timer);
 		if (status == answer_status::ERR_NONE  && !buffer.empty()) {
 			_reason_phrase = str::trim(buffer.to_string());
 		}
@@ -192,17 +170,17 @@ namespace http {
 	}
 
 
-	static bool is_valid_field_name(const std::string& field_name)
+	static bool is_valid_field_name(const char* field_name, size_t len)
 	{
 		auto& facet = std::use_facet<std::ctype<char>>(std::locale::classic());
 		
 		/* Field names should be restricted to just letters, digits, and 
 		 * hyphen('-') characters. */
 		return
-			field_name.size() > 0 &&
+			len > 0 &&
 			std::all_of(
-				field_name.begin(),
-				field_name.end(),
+				field_name,
+				field_name + len,
 				[&facet](unsigned char c) {
 					return facet.is(std::ctype_base::alnum, c) || c == '-'; 
 				}
@@ -210,31 +188,49 @@ namespace http {
 	}
 
 
-	Answer::answer_status Answer::read_headers(net::TcpSocket& socket, const utl::Timer& timer)
+	static const char SET_COOKIE[] = "Set-Cookie";
+
+
+	static bool is_blank(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+
+	Answer::answer_status Answer::read_headers(RecvBuffer& input, const utl::Timer& timer)
 	{
 		DEBUG_ENTER(_logger);
 
 ;		answer_status status;
 		ByteBuffer buffer(MAX_HEADER_SIZE);
 
-		while ((status = read_line(socket, buffer, timer)) == answer_status::ERR_NONE && !buffer.empty()) {
-			obfstring line{ buffer.to_obfstring() };
+		while ((status = read_line(input, buffer, timer)) == answer_status::ERR_NONE && !buffer.empty()) {
+			// The line is parsed in place, only the cookies are copied in
+			// obfuscated strings.
+			const char* const line = reinterpret_cast<const char*>(buffer.cbegin());
+			const char* const line_end = line + buffer.size();
 
 			// Split header into name and value at the first colon.
-			const std::string::size_type pos{ line.find(':') };
-			if (pos != std::string::npos && pos > 0) {
-				const std::string field_name{ line.substr(0, pos).uncrypt() };
+			const char* const colon = static_cast<const char*>(std::memchr(line, ':', buffer.size()));
+			if (colon && colon > line) {
+				const size_t name_len = colon - line;
 
 				// Validate the field name.
-				if (!is_valid_field_name(field_name))
+				if (!is_valid_field_name(line, name_len))
 					return answer_status::ERR_INVALID_FIELD;
 
-				const obfstring field_value{ str::trim(line.substr(pos + 1, std::string::npos)) };
+				// Trim the field value.
+				const char* value = colon + 1;
+				const char* value_end = line_end;
+				while (value < value_end && is_blank(*value))
+					value++;
+				while (value_end > value && is_blank(*(value_end - 1)))
+					value_end--;
 
-				if (str::iequal(field_name, "Set-Cookie")) {
+				if (name_len == sizeof(SET_COOKIE) - 1 && _strnicmp(line, SET_COOKIE, name_len) == 0) {
 					// A cookie definition
 					try {
-						_cookies.add(Cookie::parse(field_value));
+						_cookies.add(Cookie::parse(obfstring(value, value_end - value)));
 					}
 					catch (const cookie_error& e) {
 						_logger->debug("ERROR: %s", e.what());
@@ -242,7 +238,7 @@ namespace http {
 				}
 				else {
 					// It is a header.
-					_headers.set(field_name, field_value.uncrypt());
+					_headers.add(line, name_len, value, value_end - value);
 				}
 			}
 		}
@@ -251,88 +247,26 @@ namespace http {
 	}
 
 
-	bool Answer::read_gzip_body(net::TcpSocket& socket, size_t size, size_t max_size, const utl::Timer& timer)
-	{
-		DEBUG_ENTER(_logger);
-
-		// configure the de-compressor
-		::z_stream strm{ 0 };
-		strm.zalloc = Z_NULL;
-		strm.zfree = Z_NULL;
-		strm.opaque = Z_NULL;
-		strm.avail_in = 0;
-		strm.next_in = Z_NULL;
-		if (inflateInit2(&strm, MAX_WBITS + 32))
-			return false;
-
-		// read by chunk of 1024 bytes
-		unsigned char buffer[1024];
-		unsigned char out[1024];
-
-		do {
-			const size_t len = std::min(size, sizeof(buffer));
-			if (!read_buffer(socket, buffer, std::min(size, sizeof(buffer)), timer)) {
-				inflateEnd(&strm);
-				return false;
-			}
-
-			strm.avail_in = static_cast<uInt>(len);
-			strm.next_in = buffer;
-
-			do {
-				strm.avail_out = sizeof(out);
-				strm.next_out = out;
-
-				switch (inflate(&strm, Z_NO_FLUSH)) {
-					case Z_NEED_DICT:
-					case Z_DATA_ERROR:
-					case Z_MEM_ERROR:
-						(void)inflateEnd(&strm);
-						return false;
-				}
-				const size_t have = sizeof(out) - strm.avail_out;
-
-				const size_t available_space = max_size - _body.size();
-				if (available_space > 0) {
-					_body.append(out, std::min(have, available_space));
-				}
-			} while (strm.avail_out == 0);
-
-			size = size - len;
-		} while (size > 0);
-
-		return (inflateEnd(&strm) == Z_OK) && size == 0;
-	}
-
-
-	bool Answer::read_body(net::TcpSocket& socket, size_t size, size_t max_size, const utl::Timer& timer)
+	bool Answer::read_content(RecvBuffer& input, size_t size, BodyDecoder& decoder, const utl::Timer& timer)
 	{
 		DEBUG_ENTER_FMT(_logger, "size=%zu", size);
 
-		// read by chunk of 4096 bytes
-		std::array<unsigned char, 4096> buffer;
-
-		do {
-			// read a chunk of bytes
-			const size_t len = std::min(size, buffer.size());
-			if (!read_buffer(socket, buffer.data(), len, timer))
+		while (size > 0) {
+			// Decode the next block available in the receive buffer.
+			const unsigned char* data = nullptr;
+			const size_t len = input.read_block(data, size, timer);
+			if (len == 0 || !decoder.write(data, len))
 				break;
 
-			// append what we can in the buffer
-			const size_t available_space = max_size - _body.size();
-			if (available_space > 0) {
-				_body.append(buffer.data(), std::min(len, available_space));
-			}
-
 			size = size - len;
-		} while (size > 0);
+		}
 
 		// return True when all bytes have been read
 		return size == 0;
 	}
 
 
-	void Answer::recv(net::TcpSocket& socket, const utl::Timer& timer)
+	void Answer::recv(RecvBuffer& input, const utl::Timer& timer, BodySink* sink)
 	{
 		DEBUG_ENTER(_logger);
 		LOG_DEBUG(_logger, "timeout=%lu", timer.remaining_time());
@@ -350,11 +284,16 @@ namespace http {
 		//         the semantics of the field value
 
 		// Read status-line.
-		if ((status = read_control_data(socket, timer)) != answer_status::ERR_NONE)
+		if ((status = read_control_data(input, timer)) != answer_status::ERR_NONE)
 			throw http_error(answer_status_msg(status));
 
 		// Read message-headers. 
-		if ((status = read_headers(socket, timer)) != answer_status::ERR_NONE)
+		status = read_headers(input, timer);
+
+		// The header lines, including the cookies, are erased from the receive buffer.
+		input.erase_consumed();
+
+		if (status != answer_status::ERR_NONE)
 			throw http_error(answer_status_msg(status));
 
 		// Get the encoding scheme
@@ -383,36 +322,44 @@ namespace http {
 			content_encoding.c_str()
 		);
 
+		// The body is decoded while it is received and passed to the sink. It is
+		// stored in this answer up to a maximum size if no sink is specified.
+		BodyBuffer body_buffer{ _body, MAX_BODY_SIZE };
+		const std::unique_ptr<BodyDecoder> decoder{ BodyDecoder::create(gzip_content, sink ? *sink : body_buffer) };
+
+		// The size of a streamed body is not limited.
+		const long max_chunk_size = sink ? LONG_MAX : MAX_CHUNK_SIZE;
+		const long max_body_size = sink ? LONG_MAX : MAX_BODY_SIZE;
+
 		// Read the body.
 		// Are we using a chunked-style transfer encoding?
 		if (transfer_encoding.compare("chunked") == 0) {
-			if (gzip_content)
-				throw http_error(answer_status_msg(answer_status::ERR_CONTENT_ENCODING));
-
 			// chunked message
 			long chunk_size = 0;
 			ByteBuffer buffer(MAX_LINE_SIZE);
 
 			do {
 				// read chunk size
-				if (read_line(socket, buffer, timer) != answer_status::ERR_NONE || buffer.empty())
+				if (read_line(input, buffer, timer) != answer_status::ERR_NONE || buffer.empty())
 					throw http_error(answer_status_msg(answer_status::ERR_CHUNK_SIZE));
 
 				// decode chunk size
-				if (!str::str2num(buffer.to_string(), 16, 0, MAX_CHUNK_SIZE, chunk_size)) {
+				if (!str::str2num(buffer.to_string(), 16, 0, max_chunk_size, chunk_size)) {
 					throw http_error(answer_status_msg(answer_status::ERR_CHUNK_SIZE));
 				}
 
 				if (chunk_size > 0) {
-					if (!read_body(socket, chunk_size, MAX_BODY_SIZE, timer))
+					if (!read_content(input, chunk_size, *decoder, timer))
 						throw http_error(answer_status_msg(answer_status::ERR_BODY));
 				}
 
 				// skip eol
-				if (read_line(socket, buffer, timer) != answer_status::ERR_NONE || !buffer.empty())
+				if (read_line(input, buffer, timer) != answer_status::ERR_NONE || !buffer.empty())
 					throw http_error(answer_status_msg(answer_status::ERR_BODY));
 			} while (chunk_size > 0);
 
+			if (!decoder->finish())
+				throw http_error(answer_status_msg(answer_status::ERR_BODY));
 		}
 		else if (transfer_encoding.compare("") == 0) {
 			// read content length 
@@ -421,22 +368,17 @@ namespace http {
 			if (_headers.get("Content-Length", length)) {
 				long size = 0;
 
-				if (!str::str2num(length, 10, 0, MAX_BODY_SIZE, size)) {
+				if (!str::str2num(length, 10, 0, max_body_size, size)) {
 					throw http_error(answer_status_msg(answer_status::ERR_BODY_SIZE));
 				}
 
 				if (size > 0) {
 					// define the capacity of the buffer
-					_body.reserve(size);
+					if (!sink)
+						_body.reserve(size);
 
-					// read the whole body
-					bool body_available;
-					if (gzip_content)
-						body_available = read_gzip_body(socket, size, MAX_BODY_SIZE, timer);
-					else
-						body_available = read_body(socket, size, MAX_BODY_SIZE, timer);
-
-					if (!body_available)
+					// read and decode the whole body
+					if (!read_content(input, size, *decoder, timer) || !decoder->finish())
 						throw http_error(answer_status_msg(answer_status::ERR_BODY));
 				}
 			}
@@ -446,6 +388,9 @@ namespace http {
 			throw http_error(answer_status_msg(answer_status::ERR_TRANSFER_ENCODING));
 		}
 
+		// The body is erased from the receive buffer.
+		input.erase_consumed();
+
 		return;
 	}
 
@@ -8,9 +8,11 @@
 #pragma once
 
 #include <string>
+#include "http/BodyDecoder.h"
+#include "http/BodySink.h"
 #include "http/Cookies.h"
-#include "http/Headers.h"
-#include "net/TcpSocket.h"
+#include "http/HeaderTable.h"
+#include "http/RecvBuffer.h"
 #include "util/ByteBuffer.h"
 #include "util/Logger.h"
 #include "util/Timer.h"
@@ -40,9 +42,9 @@ namespace http {
 		void clear();
 
 		/**
-		 * Receives and parses an HTTP response from a TCP socket.
+		 * Receives and parses an HTTP response from a connection.
 		 *
-		 * Reads an HTTP response message from the given socket using the following
+		 * Reads an HTTP response message from the given receive buffer using the following
 		 * sequence:
 		 *   1. Status line
 		 *   2. Message headers
@@ -51,17 +53,22 @@ namespace http {
 		 * Unsupported or invalid encoding, malformed headers, or body read errors
 		 * result in an exception being thrown.
 		 *
-		 * The body data is stored internally in the Answer instance.
+		 * The body is decoded while it is received. It is stored internally in the
+		 * Answer instance, up to a maximum size, unless a body sink is specified.  The
+		 * sink receives the decoded body block by block, a body of any size is then
+		 * received in a bounded memory.
 		 *
-		 * @param socket TCP socket used to receive the response.
+		 * @param input  The receive buffer of the socket used to receive the response.
 		 * @param timer  A timer that specifies the timeout for reading the response.
+		 * @param sink   The consumer of the decoded body or nullptr to store the body
+		 *               in this answer.
 		 *
 		 * @throws mbed_error If an error occurs while receiving the response
 		 *                    such as network, socket-related, timeout issues.
 		 * @throws http_error If the response is malformed, uses unsupported transfer
 		 *                    or content encoding, exceeds configured size limits.
 		 */
-		void recv(net::TcpSocket& socket, const utl::Timer& timer);
+		void recv(RecvBuffer& input, const utl::Timer& timer, BodySink* sink = nullptr);
 
 		/**
 		 * Returns the HTTP status code.
@@ -77,7 +84,7 @@ namespace http {
 		 * Returns the headers collection.  The cookies are stored apart in
 		 * obfuscated strings
 		*/
-		inline const Headers& headers() const { return _headers; }
+		inline const HeaderTable& headers() const { return _headers; }
 
 		/**
 		 * Returns the cookies collection.
@@ -85,7 +92,8 @@ namespace http {
 		inline const Cookies& cookies() const { return _cookies; }
 
 		/**
-		 * Returns the body of the answer.
+		 * Returns the body of the answer, the body is empty if it was passed
+		 * to a body sink.
 		*/
 		inline const utl::ByteBuffer& body() const { return _body; }
 
@@ -103,7 +111,7 @@ namespace http {
 		std::string _reason_phrase;
 
 		// All headers except cookies
-		Headers _headers;
+		HeaderTable _headers;
 
 		// All cookies received in the answer.
 		Cookies _cookies;
@@ -134,14 +142,14 @@ namespace http {
 
 
 		/**
-		 * Reads a sequence of bytes from the socket.
+		 * Reads a sequence of bytes from the receive buffer.
 		 *
-		 * This function reads data from the socket and stores it in the buffer pointed to
+		 * This function reads data from the receive buffer and stores it in the buffer pointed to
 		 * by the `buffer` parameter. The reading continues until either the buffer is completely
 		 * filled (as specified by the `len` parameter) or the specified `timer` elapses,
 		 * whichever occurs first. If the socket is closed, the function returns false.
 		 *
-		 * @param socket The socket from which data will be read.
+		 * @param input  The receive buffer from which data will be read.
 		 * @param buffer Pointer to the buffer where the received data will be stored.
 		 * @param len The number of bytes to read, which is the size of the provided buffer.
 		 * @param timer The maximum amount of time (in milliseconds) to wait for the operation
@@ -152,35 +160,16 @@ namespace http {
 		 * @throws mbed_error If an error occurs while reading from the socket, such as network
 		 *                    failures or read timeout.
 		 */
-		bool read_buffer(net::TcpSocket& socket, unsigned char* buffer, const size_t len, const utl::Timer& timer);
+		bool read_buffer(RecvBuffer& input, unsigned char* buffer, const size_t len, const utl::Timer& timer);
 
 		/**
-		 * Reads a single byte from the socket.
+		 * Reads a string from the receive buffer until a newline sequence (\r\\n) is
+		 * encountered. The \r\\n characters are not included in the returned line.
 		 *
-		 * This function reads one byte from the socket connected to the server and
-		 * stores it in the variable `c`.
+		 * This function searches the end of the line in the received data and stores
+		 * the characters in the `buffer` parameter.
 		 *
-		 * @param socket The socket connected to the server from which the character will be read.
-		 * @param c Reference to an unsigned character variable where the received data will be stored.
-		 * @param timer The maximum amount of time to wait for the operation to complete before
-		 *              timing out.
-		 *
-		 * @return true if the character was successfully read, false if the socket is closed.
-		 *
-		 * @throws mbed_error If an error occurs while reading from the socket, such as network
-		 *                    failures or read timeout.
-		 */
-		bool read_byte(net::TcpSocket& socket, unsigned char& c, const utl::Timer& timer);
-
-		/**
-		 * Reads a string from the socket until a newline sequence (\r\\n) is encountered.
-		 * The \r\\n characters are not included in the returned line.
-		 *
-		 * This function reads characters from the socket and stores them in the `line`
-		 * parameter until the end of the line is reached (i.e., \r\\n is encountered) or
-		 * the buffer capacity is reached. 
-		 *
-		 * @param socket The socket connected to the server from which data will be read.
+		 * @param input  The receive buffer from which data will be read.
 		 * @param buffer The buffer where the read characters will be stored.
 		 * @param timer A timer specifying the maximum time to wait before the operation times out.
 		 *
@@ -190,7 +179,7 @@ namespace http {
 		 * @throws mbed_error If an error occurs while reading from the socket, such as network
 		 *                    failures or read timeout.
 		 */
-		answer_status read_line(net::TcpSocket& socket, utl::ByteBuffer& buffer, const utl::Timer& timer);
+		answer_status read_line(RecvBuffer& input, utl::ByteBuffer& buffer, const utl::Timer& timer);
 
 		/**
 		 * Reads the HTTP status response from the server.
@@ -201,7 +190,7 @@ namespace http {
 		 * content of the status line. If the socket is closed, the function returns
 		 * `ERR_INVALID_STATUS_LINE`.
 		 *
-		 * @param socket The socket connected to the server from which the status response will be read.
+		 * @param input  The receive buffer from which the status response will be read.
 		 * @param timer A timer that specifies the maximum time to wait for the operation to complete.
 		 *
 		 * @retval `ERR_NONE` if the status line was successfully read and valid.
@@ -212,7 +201,7 @@ namespace http {
 		 * @throws mbed_error If an error occurs while reading from the socket, such as network
 		 *                    failures or read timeout.
 		 */
-		answer_status read_control_data(net::TcpSocket& socket, const utl::Timer& timer);
+		answer_status read_control_data(RecvBuffer& input, const utl::Timer& timer);
 
 		/**
 		 * Reads and parses HTTP  headers from a TCP socket.
@@ -228,7 +217,7 @@ namespace http {
 		 * - An empty line is received (successful end of headers), or
 		 * - read_line() returns an error status.
 		 *
-		 * @param socket TCP socket to read header data from.
+		 * @param input  The receive buffer of the socket to read header data from.
 		 * @param timer A timer that specifies the maximum time to wait for the operation to complete.
 		 *
 		 * @retval `ERR_NONE` on successful completion.
@@ -238,55 +227,29 @@ namespace http {
 		 * @throws mbed_error If an error occurs while reading from the socket, such as network
 		 *                    failures or read timeout.
 		 */
-		answer_status read_headers(net::TcpSocket& socket, const utl::Timer& timer);
+		answer_status read_headers(RecvBuffer& input, const utl::Timer& timer);
 
 		/**
-		 * Reads and decompresses a gzip body from the server.
-		 *
-		 * This function reads the gzip-compressed body of the HTTP response, decompresses it,
-		 * and stores the result. The reading process continues until the specified size (in bytes)
-		 * is reached, the timer expires, or the decompressed body exceeds the maximum size specified
-		 * by `max_size`. If any of these conditions occur, the function stops reading.
+		 * Reads a part of the content of the HTTP response and passes it to a decoder.
 		 *
-		 * @param socket The socket connected to the server from which the compressed body will be read.
-		 * @param size The size of the gzip-compressed body (in bytes) that needs to be read and decompressed.
-		 * @param max_size The maximum size allowed for the decompressed body. If the decompressed body
-		 *                 exceeds this size, the function will stop reading.
-		 * @param timer The maximum amount of time allowed for reading and decompressing the body. The function
-		 *              stops if the timer expires before the operation is complete.
+		 * The content is passed to the decoder block by block as it is received, the
+		 * content is not copied in an intermediate buffer.  The reading stops when the
+		 * specified size is reached, the decoder fails or the socket is closed.
 		 *
-		 * @return `false` if decompression fails (e.g., if an error occurs during decompression,
-		 *         if the size exceeds `max_size`, or if the timer expires). Returns `true` if
-		 *         decompression is successful.
-		 *
-		 * @throws mbed_error If an error occurs while reading from the socket, such as network
-		 *                    failures or read timeout.
-		 */
-		bool read_gzip_body(net::TcpSocket& socket, size_t size, size_t max_size, const utl::Timer& timer);
-
-		/**
-		 * Reads the body of the HTTP response from the server in chunks and appends it to the body.
-		 *
-		 * This function reads the HTTP body from the server in chunks of 1024 bytes. The body is
-		 * read until the specified size is reached, the maximum size of the body is reached, or the
-		 * reading is interrupted by the expiration of the timer. The function ensures that the body
-		 * is stored in the `_body` member, but will stop appending once the `max_size` limit is reached.
-		 *
-		 * @param socket The socket connected to the server from which the body data will be read.
-		 * @param size The total size (in bytes) of the body to be read from the server. The function
-		 *             will attempt to read this amount of data in chunks.
-		 * @param max_size The maximum size (in bytes) that can be stored in the body buffer. The function
-		 *                 will stop appending data once this limit is reached.
-		 * @param timer A timer specifying the maximum time to wait before the operation times out.
+		 * @param input   The receive buffer from which the content will be read.
+		 * @param size    The size (in bytes) of the content to read, the size of a
+		 *                chunk or the content length of the body.
+		 * @param decoder The decoder of the content encoding.
+		 * @param timer   A timer specifying the maximum time to wait before the operation times out.
 		 *
-		 * @return `true` if all the specified bytes (as indicated by `size`) were successfully read
-		 *         and stored in the body buffer. Returns `false` if the reading process was interrupted
-		 *         by the timer expiration or any other failure condition (e.g., socket issues).
+		 * @return `true` if all the specified bytes were read and decoded. Returns `false` if
+		 *         the socket is closed or if the decoder fails (e.g., invalid compressed data
+		 *         or the body sink aborted).
 		 *
 		 * @throws mbed_error If an error occurs while reading from the socket, such as network
 		 *                    failures or read timeout.
 		 */
-		bool read_body(net::TcpSocket& socket, size_t size, size_t max_size, const utl::Timer& timer);
+		bool read_content(RecvBuffer& input, size_t size, BodyDecoder& decoder, const utl::Timer& timer);
 
 
 		static std::string answer_status_msg(answer_status);
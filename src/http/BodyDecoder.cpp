@@ -0,0 +1,141 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "BodyDecoder.h"
+
+#include <algorithm>
+#include <limits>
+
+
+namespace http {
+
+	// Size of the inflate output buffer.
+	static constexpr size_t INFLATE_BUFFER_SIZE = 64 * 1024;
+
+
+	BodyDecoder::BodyDecoder(BodySink& sink) :
+		_sink(sink)
+	{
+	}
+
+
+	BodyDecoder::~BodyDecoder()
+	{
+	}
+
+
+	std::unique_ptr<BodyDecoder> BodyDecoder::create(bool gzip, BodySink& sink)
+	{
+		if (gzip)
+			return std::make_unique<GzipDecoder>(sink);
+		else
+			return std::make_unique<IdentityDecoder>(sink);
+	}
+
+
+	IdentityDecoder::IdentityDecoder(BodySink& sink) :
+		BodyDecoder(sink)
+	{
+	}
+
+
+	bool IdentityDecoder::write(const unsigned char* data, size_t len)
+	{
+		return _sink.write(data, len);
+	}
+
+
+	bool IdentityDecoder::finish()
+	{
+		return true;
+	}
+
+
+	GzipDecoder::GzipDecoder(BodySink& sink) :
+		BodyDecoder(sink),
+		_strm{ 0 },
+		_initialized(false),
+		_ended(false),
+		_out()
+	{
+		_strm.zalloc = Z_NULL;
+		_strm.zfree = Z_NULL;
+		_strm.opaque = Z_NULL;
+		_strm.avail_in = 0;
+		_strm.next_in = Z_NULL;
+
+		// Use the largest window, detect a gzip or a zlib header.
+		_initialized = ::inflateInit2(&_strm, MAX_WBITS + 32) == Z_OK;
+	}
+
+
+	GzipDecoder::~GzipDecoder()
+	{
+		if (_initialized)
+			::inflateEnd(&_strm);
+	}
+
+
+	bool GzipDecoder::write(const unsigned char* data, size_t len)
+	{
+		if (!_initialized)
+			return false;
+
+		while (len > 0 && !_ended) {
+			// The data following the compressed stream is ignored.
+			const uInt count = static_cast<uInt>(std::min<size_t>(len, std::numeric_limits<uInt>::max()));
+			_strm.next_in = const_cast<Bytef*>(data);
+			_strm.avail_in = count;
+
+			do {
+				// Inflate directly in the buffer of the sink if it provides one.
+				size_t size = 0;
+				unsigned char* out = _sink.get_buffer(size);
+				const bool direct = out != nullptr;
+				if (!direct) {
+					if (_out.empty())
+						_out.resize(INFLATE_BUFFER_SIZE);
+
+					out = _out.data();
+					size = _out.size();
+				}
+
+				_strm.next_out = out;
+				_strm.avail_out = static_cast<uInt>(std::min<size_t>(size, std::numeric_limits<uInt>::max()));
+				const uInt avail_out = _strm.avail_out;
+
+				const int rc = ::inflate(&_strm, Z_NO_FLUSH);
+				if (rc == Z_NEED_DICT || rc == Z_DATA_ERROR || rc == Z_MEM_ERROR || rc == Z_STREAM_ERROR)
+					return false;
+
+				const size_t have = avail_out - _strm.avail_out;
+				if (direct) {
+					if (!_sink.commit(have))
+						return false;
+				}
+				else if (have > 0 && !_sink.write(out, have)) {
+					return false;
+				}
+
+				_ended = rc == Z_STREAM_END;
+			} while (_strm.avail_out == 0 && !_ended);
+
+			data += count;
+			len -= count;
+		}
+
+		return true;
+	}
+
+
+	bool GzipDecoder::finish()
+	{
+		// An empty content is accepted, otherwise the compressed stream must be complete.
+		return _initialized && (_ended || _strm.total_in == 0);
+	}
+
+}
@@ -0,0 +1,98 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <zlib.h>
+#include "http/BodySink.h"
+
+
+namespace http {
+
+	/**
+	* BodyDecoder: decodes the content of an HTTP body.
+	*
+	* The transfer decoding (content length or chunks) passes the content to
+	* the decoder, the decoder passes the decoded body to a sink.
+	*/
+	class BodyDecoder
+	{
+	public:
+		explicit BodyDecoder(BodySink& sink);
+		virtual ~BodyDecoder();
+
+		BodyDecoder(const BodyDecoder& other) = delete;
+		BodyDecoder& operator=(const BodyDecoder& other) = delete;
+
+		/**
+		 * Decodes the next block of the content.
+		 *
+		 * @return false if the content is invalid or if the sink aborted.
+		*/
+		virtual bool write(const unsigned char* data, size_t len) = 0;
+
+		/**
+		 * Terminates the decoding at the end of the content.
+		 *
+		 * @return false if the content is incomplete.
+		*/
+		virtual bool finish() = 0;
+
+		/**
+		 * Creates the decoder of a content encoding.
+		 *
+		 * @param gzip True if the content is gzip encoded.
+		*/
+		static std::unique_ptr<BodyDecoder> create(bool gzip, BodySink& sink);
+
+	protected:
+		// The consumer of the decoded body.
+		BodySink& _sink;
+	};
+
+
+	/**
+	* IdentityDecoder: passes the content unchanged.
+	*/
+	class IdentityDecoder final : public BodyDecoder
+	{
+	public:
+		explicit IdentityDecoder(BodySink& sink);
+
+		bool write(const unsigned char* data, size_t len) override;
+		bool finish() override;
+	};
+
+
+	/**
+	* GzipDecoder: inflates a gzip or a zlib content.
+	*/
+	class GzipDecoder final : public BodyDecoder
+	{
+	public:
+		explicit GzipDecoder(BodySink& sink);
+		~GzipDecoder() override;
+
+		bool write(const unsigned char* data, size_t len) override;
+		bool finish() override;
+
+	private:
+		// The inflate stream.
+		::z_stream _strm;
+
+		// True if the stream is initialized, and true when the end of the
+		// compressed stream is decoded.
+		bool _initialized;
+		bool _ended;
+
+		// The output buffer, only allocated if the sink does not provide one.
+		std::vector<unsigned char> _out;
+	};
+
+}
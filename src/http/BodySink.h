@@ -0,0 +1,55 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstddef>
+
+
+namespace http {
+
+	/**
+	* BodySink: the consumer of the body of an HTTP answer.
+	*
+	* The body is passed to the sink block by block as it is received and
+	* decoded, the size of the body is not limited by the answer.
+	*/
+	class BodySink
+	{
+	public:
+		virtual ~BodySink() = default;
+
+		/**
+		 * Receives the next block of the decoded body.
+		 *
+		 * @param data Pointer to the block, the block is valid during the call.
+		 * @param len  The size of the block.
+		 *
+		 * @return false to abort the reception of the answer.
+		*/
+		virtual bool write(const unsigned char* data, size_t len) = 0;
+
+		/**
+		 * Returns a buffer where a decoder writes the next block directly,
+		 * the decoder then calls commit() with the size of the block.
+		 *
+		 * The default implementation returns nullptr, the decoder writes the
+		 * block in its own buffer and passes it to write().
+		 *
+		 * @param size The size of the returned buffer.
+		*/
+		virtual unsigned char* get_buffer(size_t& size) { size = 0; return nullptr; }
+
+		/**
+		 * Receives the next block written in the buffer returned by get_buffer().
+		 *
+		 * @return false to abort the reception of the answer.
+		*/
+		virtual bool commit(size_t len) { return len == 0; }
+	};
+
+}
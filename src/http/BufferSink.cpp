@@ -0,0 +1,75 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "BufferSink.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace http {
+
+	// Size of the space offered to the decoder.
+	static constexpr size_t MIN_BLOCK_SIZE = 16 * 1024;
+
+
+	BufferSink::BufferSink(size_t max_size) :
+		_max_size(max_size),
+		_buffer(),
+		_size(0)
+	{
+	}
+
+
+	bool BufferSink::write(const unsigned char* data, size_t len)
+	{
+		if (!grow(len))
+			return false;
+
+		std::memcpy(_buffer.data() + _size, data, len);
+		_size += len;
+
+		return true;
+	}
+
+
+	unsigned char* BufferSink::get_buffer(size_t& size)
+	{
+		const size_t len = std::min(MIN_BLOCK_SIZE, _max_size - _size);
+		if (len == 0 || !grow(len)) {
+			size = 0;
+			return nullptr;
+		}
+
+		size = _buffer.size() - _size;
+		return _buffer.data() + _size;
+	}
+
+
+	bool BufferSink::commit(size_t len)
+	{
+		_size += len;
+
+		return true;
+	}
+
+
+	bool BufferSink::grow(size_t len)
+	{
+		if (len > _max_size - _size)
+			return false;
+
+		if (_buffer.size() - _size < len) {
+			// The buffer is doubled to limit the number of reallocations.
+			const size_t new_size = std::max(_size + len, 2 * _buffer.size());
+			_buffer.resize(std::min(new_size, _max_size));
+		}
+
+		return true;
+	}
+
+}
@@ -0,0 +1,59 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <vector>
+#include "http/BodySink.h"
+
+
+namespace http {
+
+	/**
+	* BufferSink: a body sink that stores the body in memory.
+	*
+	* The decoder writes the body directly in the buffer of the sink.  The
+	* reception of the answer is aborted if the body exceeds the maximum size.
+	*/
+	class BufferSink final : public BodySink
+	{
+	public:
+		/**
+		 * Creates a sink.
+		 *
+		 * @param max_size The maximum size of the body.
+		*/
+		explicit BufferSink(size_t max_size);
+
+		bool write(const unsigned char* data, size_t len) override;
+		unsigned char* get_buffer(size_t& size) override;
+		bool commit(size_t len) override;
+
+		/**
+		 * Returns a pointer to the received body.
+		*/
+		inline unsigned char* data() noexcept { return _buffer.data(); }
+
+		/**
+		 * Returns the size of the received body.
+		*/
+		inline size_t size() const noexcept { return _size; }
+
+	private:
+		// The maximum size of the body.
+		const size_t _max_size;
+
+		// The buffer and the number of bytes received in it.
+		std::vector<unsigned char> _buffer;
+		size_t _size;
+
+		// Makes room for at least `len` bytes, returns false if the
+		// maximum size would be exceeded.
+		bool grow(size_t len);
+	};
+
+}
@@ -0,0 +1,131 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "HeaderTable.h"
+
+#include <cstring>
+
+
+namespace http {
+
+	// Initial capacity of the table, enough for the answers of a firewall.
+	static constexpr size_t DATA_CAPACITY = 4 * 1024;
+	static constexpr size_t ENTRY_CAPACITY = 32;
+
+
+	static inline unsigned char lower(unsigned char c) noexcept
+	{
+		// Header names are restricted to ASCII letters, digits and hyphens.
+		return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+	}
+
+
+	HeaderTable::HeaderTable() :
+		_data(DATA_CAPACITY),
+		_entries()
+	{
+		_entries.reserve(ENTRY_CAPACITY);
+	}
+
+
+	HeaderTable::~HeaderTable()
+	{
+	}
+
+
+	void HeaderTable::clear() noexcept
+	{
+		_data.clear();
+		_entries.clear();
+	}
+
+
+	void HeaderTable::add(const char* name, size_t name_len, const char* value, size_t value_len)
+	{
+		const size_t index = find_entry(name, name_len);
+
+		entry e;
+		e.hash = hash(name, name_len);
+		e.name_pos = static_cast<uint32_t>(_data.size());
+		e.name_len = static_cast<uint32_t>(name_len);
+		_data.append(reinterpret_cast<const uint8_t*>(name), name_len);
+		e.value_pos = static_cast<uint32_t>(_data.size());
+		e.value_len = static_cast<uint32_t>(value_len);
+		_data.append(reinterpret_cast<const uint8_t*>(value), value_len);
+
+		// The last definition of a header replaces the previous one.
+		if (index < _entries.size())
+			_entries[index] = e;
+		else
+			_entries.push_back(e);
+	}
+
+
+	bool HeaderTable::find(const char* name, const char*& value, size_t& len) const noexcept
+	{
+		const size_t index = find_entry(name, std::strlen(name));
+		if (index == _entries.size())
+			return false;
+
+		const entry& e = _entries[index];
+		value = reinterpret_cast<const char*>(_data.cbegin()) + e.value_pos;
+		len = e.value_len;
+
+		return true;
+	}
+
+
+	bool HeaderTable::get(const std::string& name, std::string& value) const
+	{
+		const size_t index = find_entry(name.data(), name.size());
+		if (index == _entries.size())
+			return false;
+
+		const entry& e = _entries[index];
+		value.assign(reinterpret_cast<const char*>(_data.cbegin()) + e.value_pos, e.value_len);
+
+		return true;
+	}
+
+
+	size_t HeaderTable::find_entry(const char* name, size_t name_len) const noexcept
+	{
+		const uint32_t name_hash = hash(name, name_len);
+		const unsigned char* const data = _data.cbegin();
+
+		for (size_t index = 0; index < _entries.size(); index++) {
+			const entry& e = _entries[index];
+			if (e.hash != name_hash || e.name_len != name_len)
+				continue;
+
+			// Confirm the match, the comparison ignores the case.
+			const unsigned char* const p = data + e.name_pos;
+			size_t i = 0;
+			while (i < name_len && lower(p[i]) == lower(static_cast<unsigned char>(name[i])))
+				i++;
+
+			if (i == name_len)
+				return index;
+		}
+
+		return _entries.size();
+	}
+
+
+	uint32_t HeaderTable::hash(const char* name, size_t len) noexcept
+	{
+		// FNV-1a computed on the lower case name.
+		uint32_t h = 2166136261u;
+		for (size_t i = 0; i < len; i++) {
+			h ^= lower(static_cast<unsigned char>(name[i]));
+			h *= 16777619u;
+		}
+
+		return h;
+	}
+
+}
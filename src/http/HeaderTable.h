@@ -0,0 +1,101 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "util/ByteBuffer.h"
+
+
+namespace http {
+
+	/**
+	* HeaderTable: the headers of an HTTP answer.
+	*
+	* Names and values are stored one after the other in a single buffer and
+	* indexed by a small flat table.  Each entry holds a case insensitive hash
+	* of the name computed when the header is parsed, a lookup compares the
+	* hashes before the names.  Adding a header does not allocate memory once
+	* the buffer and the table have reached the size of a typical answer.
+	*
+	* A value is copied only when it is requested.
+	*/
+	class HeaderTable final
+	{
+	public:
+		HeaderTable();
+		~HeaderTable();
+
+		HeaderTable(const HeaderTable& other) = delete;
+		HeaderTable& operator=(const HeaderTable& other) = delete;
+
+		/**
+		 * Removes and erases all headers, the capacity is kept.
+		*/
+		void clear() noexcept;
+
+		/**
+		 * Adds a header, the name and the value are copied in the table.
+		 *
+		 * A header already defined is replaced by this one.
+		*/
+		void add(const char* name, size_t name_len, const char* value, size_t value_len);
+
+		/**
+		 * Finds a header.
+		 *
+		 * @param name  The name of the header, the case is ignored.
+		 * @param value Receives a pointer to the value in the table, the pointer is
+		 *              valid until the table is modified.
+		 * @param len   Receives the size of the value.
+		 *
+		 * @return true if the header is defined.
+		*/
+		bool find(const char* name, const char*& value, size_t& len) const noexcept;
+
+		/**
+		 * Gets a copy of the value of a header.
+		 *
+		 * @param name  The name of the header, the case is ignored.
+		 * @param value The value of the header.
+		 *
+		 * @return true if the header is defined.
+		*/
+		bool get(const std::string& name, std::string& value) const;
+
+		/**
+		 * Returns the number of headers.
+		*/
+		inline size_t size() const noexcept { return _entries.size(); }
+
+	private:
+		struct entry {
+			uint32_t hash;					// case insensitive hash of the name
+			uint32_t name_pos;				// position of the name in the buffer
+			uint32_t name_len;
+			uint32_t value_pos;				// position of the value in the buffer
+			uint32_t value_len;
+		};
+
+		// The names and the values of all headers.
+		utl::ByteBuffer _data;
+
+		// The index of the headers.
+		std::vector<entry> _entries;
+
+		// Returns the index of the entry of a header or the number of entries
+		// if the header is not defined.
+		size_t find_entry(const char* name, size_t name_len) const noexcept;
+
+		// Computes the case insensitive hash of a name.
+		static uint32_t hash(const char* name, size_t len) noexcept;
+	};
+
+}
@@ -10,7 +10,6 @@
 #include <algorithm>
 #include <cctype>
 #include <iostream>
-#include <sstream>
 #include "util/StringMap.h"
 #include "net/TlsContext.h"
 
@@ -33,6 +32,12 @@ namespace http {
 	const int DEFAULT_SND_TIMEOUT = 10;
 	const int DEFAULT_RCV_TIMEOUT = 10;
 
+	// The receive buffer holds a TLS record.
+	const size_t RECV_BUFFER_SIZE = 16 * 1024;
+
+	// The initial capacity of the output buffer, it grows with the requests.
+	const size_t SEND_BUFFER_SIZE = 4 * 1024;
+
 	HttpsClient::HttpsClient(const net::Endpoint& ep, const net::TlsConfig& config) :
 		TlsSocket(config),
 		_host_ep(ep),
@@ -42,7 +47,9 @@ namespace http {
 		_connect_timeout(DEFAULT_CONNECT_TIMEOUT * 1000),
 		_send_timeout(DEFAULT_SND_TIMEOUT * 1000),
 		_receive_timeout(DEFAULT_RCV_TIMEOUT * 1000),
-		_request_count(0)
+		_request_count(0),
+		_recv_buffer(*this, RECV_BUFFER_SIZE),
+		_send_buffer(SEND_BUFFER_SIZE)
 	{
 		DEBUG_CTOR(_logger);
 	}
@@ -85,6 +92,7 @@ namespace http {
 
 		_keepalive_timer.start(_keepalive_timeout * 1000);
 		_request_count = 0;
+		_recv_buffer.clear();
 
 		utl::Timer connect_timer{ _connect_timeout };
 
@@ -103,6 +111,27 @@ namespace http {
 		DEBUG_ENTER(_logger);
 
 		TlsSocket::shutdown();
+		_recv_buffer.clear();
+		_send_buffer.clear();
+	}
+
+
+	bool HttpsClient::take_over(HttpsClient& other)
+	{
+		DEBUG_ENTER(_logger);
+
+		// A connection that the server is about to close is not adopted, the
+		// caller then opens a new connection.
+		if (_host_ep.to_string().compare(other._host_ep.to_string()) != 0 ||
+			other.is_reconnection_required() ||
+			!TlsSocket::take_over(other))
+			return false;
+
+		_keepalive_timer.start(other._keepalive_timer.remaining_time());
+		_request_count = other._request_count;
+		_recv_buffer.take_over(other._recv_buffer);
+
+		return true;
 	}
 
 
@@ -115,7 +144,7 @@ namespace http {
 			_keepalive_timeout
 		);
 
-		request.send(*this, utl::Timer{ _send_timeout });
+		request.send(*this, _send_buffer, utl::Timer{ _send_timeout });
 
 		// Update the number of requests and restart the keep alive timer
 		_request_count++;
@@ -131,7 +160,7 @@ namespace http {
 	}
 
 
-	void HttpsClient::recv_answer(Answer& answer)
+	void HttpsClient::recv_answer(Answer& answer, BodySink* sink)
 	{
 		DEBUG_ENTER(_logger);
 
@@ -139,7 +168,7 @@ namespace http {
 		answer.clear();
 
 		// Receive the answer from the server.
-		answer.recv(*this, utl::Timer{ _receive_timeout });
+		answer.recv(_recv_buffer, utl::Timer{ _receive_timeout }, sink);
 		LOG_DEBUG(_logger, "status=%3.3d body size=%zu",
 			answer.get_status_code(),
 			answer.body().size()
@@ -170,22 +199,23 @@ namespace http {
 	{
 		static const char hexstr[] = "0123456789abcdef";
 
-		// Allocate output buffer
-		std::stringstream escaped;
+		// Allocate output buffer, an escaped character takes 3 characters.
+		std::string escaped;
+		escaped.reserve(str.size() * 3);
 
 		for (unsigned char c : str) {
 			// RFC 3986 unreserved characters
 			if (std::isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~') {
-				escaped << static_cast<char>(c);
+				escaped.push_back(static_cast<char>(c));
 			}
 			else {
-				escaped << "%";
-				escaped << hexstr[(c & 0xF0) >> 4];
-				escaped << hexstr[c & 0x0F];
+				escaped.push_back('%');
+				escaped.push_back(hexstr[(c & 0xF0) >> 4]);
+				escaped.push_back(hexstr[c & 0x0F]);
 			}
 		}
 
-		return escaped.str();
+		return escaped;
 	}
 
 
@@ -12,9 +12,12 @@
 #include <string>
 #include "http/Request.h"
 #include "http/Answer.h"
+#include "http/BodySink.h"
+#include "http/RecvBuffer.h"
 #include "http/Url.h"
 #include "net/Endpoint.h"
 #include "net/TlsSocket.h"
+#include "util/ByteBuffer.h"
 #include "util/Timer.h"
 
 
@@ -64,6 +67,19 @@ namespace http {
 		*/
 		void disconnect();
 
+		/**
+		 * Takes over the established connection of another client.
+		 *
+		 * The keep alive timer and the request counter of the connection are
+		 * transferred as well.  The other client reconnects when it sends its
+		 * next request.
+		 *
+		 * @return false if the other client is not connected to the same endpoint
+		 *         or if its keep alive timeout or maximum number of requests is
+		 *         reached.
+		*/
+		bool take_over(HttpsClient& other);
+
 		/**
 		 * Sends a send_request to the server.
 		 *
@@ -90,14 +106,18 @@ namespace http {
 		 * It also extracts the `Keep-Alive` header parameters, setting the connection
 		 * timeout and maximum request count values accordingly.
 		 *
+		 * The body is stored in the answer unless a body sink is specified, the sink
+		 * then receives the decoded body as it is received.
+		 *
 		 * @param answer The `Answer` object that will hold the received response.
+		 * @param sink   The consumer of the body or nullptr to store the body in the answer.
 		 *
 		 * @throws mbed_error If an error occurs while receiving the response
 		 *                    such as network, socket-related, timeout issues.
 		 * @throws http_error If an error occurs while receiving the response,
 		 *                    such as invalid status line, version, or body.
 		 */
-		void recv_answer(Answer& answer);
+		void recv_answer(Answer& answer, BodySink* sink = nullptr);
 
 		/**
 		 * Encodes an utf8 string that can be used in a query part of a URL.
@@ -162,6 +182,12 @@ namespace http {
 
 		// Number of requests sent since last connection.
 		int _request_count;
+
+		// The data received from the server and not yet parsed.
+		RecvBuffer _recv_buffer;
+
+		// The output buffer in which the requests are serialized.
+		utl::ByteBuffer _send_buffer;
 	};
 
 
@@ -0,0 +1,213 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "RecvBuffer.h"
+
+#include <Windows.h>
+#include <algorithm>
+#include <cstring>
+#include "util/ErrUtil.h"
+
+
+namespace http {
+	using namespace utl;
+	using namespace net;
+
+
+	RecvBuffer::RecvBuffer(net::TcpSocket& socket, size_t capacity) :
+		_logger(Logger::get_logger()),
+		_socket(socket),
+		_data(capacity),
+		_begin(0),
+		_end(0)
+	{
+		DEBUG_CTOR(_logger);
+	}
+
+
+	RecvBuffer::~RecvBuffer()
+	{
+		DEBUG_DTOR(_logger);
+
+		clear();
+	}
+
+
+	void RecvBuffer::clear() noexcept
+	{
+		erase(0, _data.size());
+		_begin = 0;
+		_end = 0;
+	}
+
+
+	void RecvBuffer::erase_consumed() noexcept
+	{
+		erase(0, _begin);
+	}
+
+
+	void RecvBuffer::take_over(RecvBuffer& other)
+	{
+		DEBUG_ENTER_FMT(_logger, "size=%zu", other.size());
+
+		// The data of this buffer is erased by the other buffer.
+		_data.swap(other._data);
+		std::swap(_begin, other._begin);
+		std::swap(_end, other._end);
+		other.clear();
+	}
+
+
+	bool RecvBuffer::read(unsigned char* data, size_t len, const utl::Timer& timer)
+	{
+		TRACE_ENTER_FMT(_logger, "buffer=0x%012Ix size=%zu buffered=%zu",
+			PTR_VAL(data),
+			len,
+			size()
+		);
+
+		while (len > 0) {
+			if (size() == 0 && len >= _data.size()) {
+				// A large block is received directly in the destination buffer.
+				const rcv_status status{ _socket.read(data, len, timer) };
+				if (status.code == rcv_status_code::NETCTX_RCV_ERROR || status.code == rcv_status_code::NETCTX_RCV_RETRY)
+					throw mbed_error(status.rc);
+
+				return status.code == rcv_status_code::NETCTX_RCV_OK;
+			}
+
+			if (size() == 0 && !fill(timer))
+				return false;
+
+			const size_t count = std::min(len, size());
+			std::memcpy(data, _data.data() + _begin, count);
+			_begin += count;
+			data += count;
+			len -= count;
+		}
+
+		return true;
+	}
+
+
+	bool RecvBuffer::read_line(utl::ByteBuffer& line, size_t max_size, const utl::Timer& timer)
+	{
+		TRACE_ENTER_FMT(_logger, "buffer=0x%012Ix buffered=%zu",
+			PTR_VAL(std::addressof(line)),
+			size()
+		);
+
+		// The number of buffered bytes without a line feed.
+		size_t scanned = 0;
+
+		line.clear();
+
+		while (true) {
+			const size_t from = _begin + scanned;
+			const void* const lf = std::memchr(_data.data() + from, '\n', _end - from);
+
+			if (lf) {
+				const size_t pos = static_cast<const unsigned char*>(lf) - _data.data();
+
+				if (pos > _begin && _data[pos - 1] == '\r') {
+					move_to(line, pos - 1 - _begin, max_size);
+					_begin += 2;
+
+					return true;
+				}
+
+				// A line feed without carriage return belongs to the line.
+				scanned = pos + 1 - _begin;
+			}
+			else {
+				scanned = size();
+
+				if (_begin == 0 && _end == _data.size()) {
+					// The buffer is full, the beginning of the line is moved to
+					// the output except a carriage return that can be followed
+					// by a line feed.
+					const size_t count = _data[_end - 1] == '\r' ? size() - 1 : size();
+					move_to(line, count, max_size);
+					scanned -= count;
+				}
+
+				if (!fill(timer))
+					return false;
+			}
+		}
+	}
+
+
+	size_t RecvBuffer::read_block(const unsigned char*& data, size_t max_len, const utl::Timer& timer)
+	{
+		TRACE_ENTER_FMT(_logger, "size=%zu buffered=%zu", max_len, size());
+
+		if (max_len == 0 || (size() == 0 && !fill(timer)))
+			return 0;
+
+		const size_t count = std::min(max_len, size());
+		data = _data.data() + _begin;
+		_begin += count;
+
+		return count;
+	}
+
+
+	bool RecvBuffer::fill(const utl::Timer& timer)
+	{
+		if (_begin == _end) {
+			erase(0, _end);
+			_begin = 0;
+			_end = 0;
+		}
+		else if (_begin > 0) {
+			// Move the buffered data to the beginning of the buffer, the
+			// copy left after the data is erased.
+			const size_t end = _end;
+			std::memmove(_data.data(), _data.data() + _begin, size());
+			_end -= _begin;
+			_begin = 0;
+			erase(_end, end);
+		}
+
+		const rcv_status status{ _socket.read_some(_data.data() + _end, _data.size() - _end, timer) };
+		switch (status.code) {
+		case rcv_status_code::NETCTX_RCV_ERROR:
+		case rcv_status_code::NETCTX_RCV_RETRY:
+			// read failed or timed out
+			throw mbed_error(status.rc);
+
+		case rcv_status_code::NETCTX_RCV_OK:
+			_end += status.rbytes;
+			return true;
+
+		case rcv_status_code::NETCTX_RCV_EOF:
+		default:
+			return false;
+		}
+	}
+
+
+	void RecvBuffer::erase(size_t from, size_t to) noexcept
+	{
+		if (to > from)
+			::SecureZeroMemory(_data.data() + from, to - from);
+	}
+
+
+	void RecvBuffer::move_to(utl::ByteBuffer& line, size_t len, size_t max_size)
+	{
+		if (line.size() < max_size)
+			line.append(_data.data() + _begin, std::min(len, max_size - line.size()));
+
+		_begin += len;
+	}
+
+
+	const char* RecvBuffer::__class__ = "RecvBuffer";
+}
@@ -0,0 +1,140 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "net/TcpSocket.h"
+#include "util/ByteBuffer.h"
+#include "util/Logger.h"
+#include "util/Timer.h"
+
+
+namespace http {
+
+	/**
+	* RecvBuffer: a receive buffer of an HTTP connection.
+	*
+	* The buffer reads the data available from the socket in a single call, up
+	* to a TLS record.  The lines of the status and of the headers are searched
+	* in the buffered data, and the body is first copied from it.  The data
+	* received after an answer is kept for the next answer.
+	*
+	* The buffer holds decrypted answers, the bytes are erased once they are
+	* consumed and when the buffer is cleared.
+	*/
+	class RecvBuffer final
+	{
+	public:
+		/**
+		 * Creates a receive buffer.
+		 *
+		 * @param socket   The socket from which the data is received.
+		 * @param capacity The size of the buffer.
+		*/
+		RecvBuffer(net::TcpSocket& socket, size_t capacity);
+		~RecvBuffer();
+
+		RecvBuffer(const RecvBuffer& other) = delete;
+		RecvBuffer& operator=(const RecvBuffer& other) = delete;
+
+		/**
+		 * Discards and erases the buffered data.
+		*/
+		void clear() noexcept;
+
+		/**
+		 * Erases the bytes already read, the buffered data is kept.
+		*/
+		void erase_consumed() noexcept;
+
+		/**
+		 * Takes over the data buffered by another receive buffer.
+		*/
+		void take_over(RecvBuffer& other);
+
+		/**
+		 * Reads a sequence of bytes.
+		 *
+		 * @param data  Pointer to the buffer where the data will be stored.
+		 * @param len   The number of bytes to read.
+		 * @param timer The maximum amount of time to wait for the data.
+		 *
+		 * @return true if read succeeded, or false if the socket is closed.
+		 *
+		 * @throws mbed_error If an error occurs while reading from the socket, such as network
+		 *                    failures or read timeout.
+		*/
+		bool read(unsigned char* data, size_t len, const utl::Timer& timer);
+
+		/**
+		 * Reads a line terminated by \\r\\n, the \\r\\n characters are not
+		 * included in the line.
+		 *
+		 * @param line     The buffer where the line will be stored.
+		 * @param max_size The maximum size of the line, the next characters are
+		 *                 discarded.
+		 * @param timer    The maximum amount of time to wait for the data.
+		 *
+		 * @return true if a line is read, or false if the socket is closed.
+		 *
+		 * @throws mbed_error If an error occurs while reading from the socket, such as network
+		 *                    failures or read timeout.
+		*/
+		bool read_line(utl::ByteBuffer& line, size_t max_size, const utl::Timer& timer);
+
+		/**
+		 * Reads the next block of bytes without copying them.
+		 *
+		 * The block is taken from the buffered data, the buffer is filled
+		 * from the socket when it is empty.
+		 *
+		 * @param data    Receives a pointer to the block, the block is valid
+		 *                until the next call to this receive buffer.
+		 * @param max_len The maximum size of the block.
+		 * @param timer   The maximum amount of time to wait for the data.
+		 *
+		 * @return the size of the block, or 0 if the socket is closed.
+		 *
+		 * @throws mbed_error If an error occurs while reading from the socket, such as network
+		 *                    failures or read timeout.
+		*/
+		size_t read_block(const unsigned char*& data, size_t max_len, const utl::Timer& timer);
+
+		/**
+		 * Returns the number of buffered bytes.
+		*/
+		inline size_t size() const noexcept { return _end - _begin; }
+
+	private:
+		// The class name
+		static const char* __class__;
+
+		// A reference to the application logger.
+		utl::Logger* const _logger;
+
+		// The socket from which the data is received.
+		net::TcpSocket& _socket;
+
+		// The buffer, the buffered data is between _begin and _end.
+		std::vector<unsigned char> _data;
+		size_t _begin;
+		size_t _end;
+
+		// Appends the data available from the socket, returns false if the
+		// socket is closed.
+		bool fill(const utl::Timer& timer);
+
+		// Erases the bytes between the two offsets.
+		void erase(size_t from, size_t to) noexcept;
+
+		// Moves buffered bytes to a line, up to the maximum size of the line.
+		void move_to(utl::ByteBuffer& line, size_t len, size_t max_size);
+	};
+
+}
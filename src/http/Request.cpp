@@ -25,6 +25,9 @@ namespace http {
 	const std::string Request::OPTIONS_VERB = "OPTIONS";
 	const std::string Request::TRACE_VERB = "TRACE";
 
+	// Initial capacity of the output buffer for the request line and the headers.
+	const size_t HEADERS_RESERVE = 2048;
+
 
 	Request::Request(const std::string& verb, const http::Url& url, const http::Cookies& cookie_jar) :
 		_logger(Logger::get_logger()),
@@ -67,7 +70,7 @@ namespace http {
 	}
 
 
-	void Request::send(net::TcpSocket& socket, const utl::Timer& timer)
+	void Request::send(net::TcpSocket& socket, utl::ByteBuffer& buffer, const utl::Timer& timer)
 	{
 		DEBUG_ENTER_FMT(_logger, "timeout=%lu", timer.remaining_time());
 
@@ -75,10 +78,18 @@ namespace http {
 			_headers.set("Content-Length", _body.size());
 		}
 
-		ByteBuffer buffer(1024);
+		// The buffer is cleared before it is reused.
+		buffer.clear();
+		buffer.reserve(HEADERS_RESERVE + _body.size());
+
+		// Append the request line, the request target is the implicit url.
+		buffer.append(_verb).append(' ').append(_url.get_path());
+		if (_url.get_query().length() > 0)
+			buffer.append('?').append(_url.get_query());
+		if (_url.get_fragment().length() > 0)
+			buffer.append('#').append(_url.get_fragment());
 		buffer
-			.append(_verb).append(' ')
-			.append(_url.to_string(true)).append(' ')
+			.append(' ')
 			.append("HTTP/1.1")
 			.append("\r\n");
 
@@ -87,28 +98,41 @@ namespace http {
 
 		// Add cookies, cookies are still obfuscated at this stage
 		utl::obfstring cookie_header{ _cookies.to_header(_url) };
-		if (cookie_header.size() > 0) {
-			// Cookies are appended decrypted in the buffer.
-			buffer
-				.append("Cookie: ")
-				.append(cookie_header)
-				.append("\r\n");
-		}
-		buffer.append("\r\n");
 
-		// Send headers to the web server.
-		LOG_DEBUG(_logger, "write headers");
-		write_buffer(socket, buffer.cbegin(), buffer.size(), timer);
+		// The buffer must hold the cookies and the body before the cookies are
+		// decrypted in it, a reallocation would leave a copy of the cookies in
+		// the released memory.
+		static const std::string cookie_prefix{ "Cookie: " };
+		const size_t cookie_size = cookie_header.size() > 0 ? cookie_prefix.size() + cookie_header.size() + 2 : 0;
+		buffer.reserve(buffer.size() + cookie_size + 2 + _body.size());
+
+		try {
+			if (cookie_header.size() > 0) {
+				// Cookies are appended decrypted in the buffer.
+				buffer
+					.append(cookie_prefix)
+					.append(cookie_header)
+					.append("\r\n");
+			}
+			buffer.append("\r\n");
+
+			// Append the body, headers and body are sent in a single write.
+			const size_t headers_size = buffer.size();
+			if (!_body.empty())
+				buffer.append(_body.cbegin(), _body.size());
+
+			LOG_DEBUG(_logger, "write request headers=%zu body=%zu", headers_size, _body.size());
+			write_buffer(socket, buffer.cbegin(), buffer.size(), timer);
+		}
+		catch (...) {
+			// Erase sensitive data, the buffer is kept by the caller.
+			buffer.clear();
+			throw;
+		}
 
 		// Erase sensitive data.
 		buffer.clear();
 
-		if (!_body.empty()) {
-			// Send the body to the web server.
-			LOG_DEBUG(_logger, "write body");
-			write_buffer(socket, _body.cbegin(), _body.size(), timer);
-		}
-
 		return;
 	}
 
@@ -82,8 +82,14 @@ namespace http {
 		 * request is properly sent over the network, and will throw an exception if any error
 		 * occurs during the transmission.
 		 *
+		 * The request line, the headers and the body are serialized in the output buffer
+		 * and sent in a single write, a small request fits in one TLS record.  The buffer
+		 * is erased once the request is sent or if the send fails, its capacity is kept
+		 * for the next request.
+		 *
 		 * @param socket The socket connected to the server through which the HTTP request
 		 *               will be sent.
+		 * @param buffer The output buffer used to serialize the request.
 		 * @param timer A timer that specifies the maximum time allowed for the send operation.
 		 *              If the operation takes longer than the specified time, it will be
 		 *              canceled.
@@ -91,7 +97,7 @@ namespace http {
 		 * @throws mbed_error If an error occurs while sending the request, such as network
 		 *                    issues or socket failure.
 		 */
-		void send(net::TcpSocket& socket, const utl::Timer& timer);
+		void send(net::TcpSocket& socket, utl::ByteBuffer& buffer, const utl::Timer& timer);
 
 		/* Most common HTTP verbs */
 		static const std::string GET_VERB;
@@ -0,0 +1,135 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "AeadSelector.h"
+
+#include <windows.h>
+#include <intrin.h>
+#include <vector>
+#include <mbedtls/chachapoly.h>
+#include <mbedtls/gcm.h>
+#include "util/SysUtil.h"
+
+
+namespace net {
+	using namespace utl;
+
+	// Duration of the measure of a cipher for a record size (in us).
+	static constexpr uint64_t MEASURE_TIME = 5000;
+
+	// Sizes of the records encrypted by the benchmark, a full TLS record and
+	// a small interactive record.
+	static const size_t RECORD_SIZES[] = { 16384, 1024 };
+
+
+	bool AeadSelector::has_aes_acceleration() noexcept
+	{
+#if defined(_M_X64) || defined(_M_IX86)
+		int info[4];
+
+		__cpuid(info, 1);
+
+		// ECX bit 25 : AES-NI, ECX bit 1 : PCLMULQDQ
+		return (info[2] & (1 << 25)) != 0 && (info[2] & (1 << 1)) != 0;
+#elif defined(_M_ARM64)
+		return ::IsProcessorFeaturePresent(PF_ARM_V8_CRYPTO_INSTRUCTIONS_AVAILABLE) != FALSE;
+#else
+		return false;
+#endif
+	}
+
+
+	aead_cipher AeadSelector::detect() noexcept
+	{
+		return has_aes_acceleration() ? aead_cipher::AES_GCM : aead_cipher::CHACHA20_POLY1305;
+	}
+
+
+	aead_cipher AeadSelector::benchmark()
+	{
+		// The result is computed once, the initialization is thread safe.
+		static const aead_cipher fastest = []() {
+			Logger* const logger = Logger::get_logger();
+			double aes_total = 0;
+			double chacha_total = 0;
+
+			for (const size_t record_size : RECORD_SIZES) {
+				const double aes = measure(aead_cipher::AES_GCM, record_size);
+				const double chacha = measure(aead_cipher::CHACHA20_POLY1305, record_size);
+
+				logger->debug(">> %s record=%zu %.0f MB/s", name(aead_cipher::AES_GCM), record_size, aes);
+				logger->debug(">> %s record=%zu %.0f MB/s", name(aead_cipher::CHACHA20_POLY1305), record_size, chacha);
+
+				aes_total += aes;
+				chacha_total += chacha;
+			}
+
+			return aes_total >= chacha_total ? aead_cipher::AES_GCM : aead_cipher::CHACHA20_POLY1305;
+		}();
+
+		return fastest;
+	}
+
+
+	const char* AeadSelector::name(aead_cipher cipher) noexcept
+	{
+		return cipher == aead_cipher::AES_GCM ? "AES-128-GCM" : "CHACHA20-POLY1305";
+	}
+
+
+	double AeadSelector::measure(aead_cipher cipher, size_t record_size)
+	{
+		// The key and the nonce are irrelevant, the output is discarded.
+		const unsigned char key[32] = { 0 };
+		const unsigned char nonce[12] = { 0 };
+		unsigned char tag[16];
+		std::vector<unsigned char> input(record_size, 0x5a);
+		std::vector<unsigned char> output(record_size);
+
+		mbedtls_gcm_context gcm;
+		mbedtls_chachapoly_context chachapoly;
+		int rc;
+
+		::mbedtls_gcm_init(&gcm);
+		::mbedtls_chachapoly_init(&chachapoly);
+
+		if (cipher == aead_cipher::AES_GCM)
+			rc = ::mbedtls_gcm_setkey(&gcm, MBEDTLS_CIPHER_ID_AES, key, 128);
+		else
+			rc = ::mbedtls_chachapoly_setkey(&chachapoly, key);
+
+		uint64_t bytes = 0;
+		const uint64_t start = utl::now_us();
+		uint64_t elapsed = 0;
+
+		while (rc == 0 && elapsed < MEASURE_TIME) {
+			if (cipher == aead_cipher::AES_GCM)
+				rc = ::mbedtls_gcm_crypt_and_tag(&gcm, MBEDTLS_GCM_ENCRYPT, record_size, nonce, sizeof(nonce),
+					nullptr, 0, input.data(), output.data(), sizeof(tag), tag);
+			else
+				rc = ::mbedtls_chachapoly_encrypt_and_tag(&chachapoly, record_size, nonce,
+					nullptr, 0, input.data(), output.data(), tag);
+
+			bytes += record_size;
+			elapsed = utl::now_us() - start;
+		}
+
+		::mbedtls_gcm_free(&gcm);
+		::mbedtls_chachapoly_free(&chachapoly);
+
+		if (rc != 0) {
+			LOG_DEBUG(Logger::get_logger(), "%s rc=%d", name(cipher), rc);
+			return 0;
+		}
+
+		// bytes per us is equal to MB/s
+		return elapsed > 0 ? static_cast<double>(bytes) / elapsed : 0;
+	}
+
+
+	const char* AeadSelector::__class__ = "AeadSelector";
+}
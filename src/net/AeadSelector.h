@@ -0,0 +1,69 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstddef>
+#include "util/Logger.h"
+
+
+namespace net {
+
+	/**
+	* The AEAD ciphers offered by the client.
+	*/
+	enum class aead_cipher {
+		AES_GCM,
+		CHACHA20_POLY1305
+	};
+
+
+	/**
+	* AeadSelector: selects the AEAD cipher the client prefers.
+	*
+	* AES-GCM is several times faster than ChaCha20-Poly1305 when the processor
+	* implements the AES and carry-less multiplication instructions, ChaCha20
+	* is faster otherwise.
+	*/
+	class AeadSelector final
+	{
+	public:
+		/**
+		 * Returns true if the processor accelerates AES-GCM (AES-NI and PCLMULQDQ
+		 * on x86, the cryptographic extension on ARMv8).
+		*/
+		static bool has_aes_acceleration() noexcept;
+
+		/**
+		 * Returns the preferred cipher according to the processor capabilities.
+		*/
+		static aead_cipher detect() noexcept;
+
+		/**
+		 * Measures the throughput of each cipher and returns the fastest one.
+		 *
+		 * The measure takes a few tens of milliseconds, it is done only once and
+		 * the result is reused by the next calls.  The throughput of each cipher
+		 * and record size is logged at the debug level.
+		*/
+		static aead_cipher benchmark();
+
+		/**
+		 * Returns the name of a cipher.
+		*/
+		static const char* name(aead_cipher cipher) noexcept;
+
+	private:
+		// The class name
+		static const char* __class__;
+
+		// Returns the throughput (MB/s) of a cipher encrypting records of the
+		// specified size, 0 if the cipher failed.
+		static double measure(aead_cipher cipher, size_t record_size);
+	};
+
+}
@@ -0,0 +1,149 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "BackendPool.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <lwip/sys.h>
+
+
+namespace net {
+	using namespace utl;
+
+	// A failed backend is put aside for 5 s, this delay is doubled after each
+	// consecutive failure up to 60 s.
+	static constexpr uint32_t MIN_RETRY_DELAY = 5 * 1000;
+	static constexpr uint32_t MAX_RETRY_DELAY = 60 * 1000;
+
+
+	BackendPool::BackendPool(const net::Endpoints& endpoints, balancing_policy policy) :
+		_logger(Logger::get_logger()),
+		_policy(policy),
+		_backends(),
+		_next(0)
+	{
+		DEBUG_CTOR(_logger);
+
+		if (endpoints.empty())
+			throw std::invalid_argument("empty backend list");
+
+		for (const net::Endpoint& endpoint : endpoints)
+			_backends.push_back(backend{ endpoint, 0, 0, 0, 0 });
+	}
+
+
+	BackendPool::~BackendPool()
+	{
+		DEBUG_DTOR(_logger);
+	}
+
+
+	bool BackendPool::select(const std::vector<bool>& tried, size_t& index)
+	{
+		const uint32_t now = sys_now();
+		const size_t count = _backends.size();
+		bool found = false;
+		size_t selected = 0;
+
+		// Search an available backend according to the policy.
+		for (size_t k = 0; k < count; k++) {
+			const size_t i = (_policy == balancing_policy::ROUND_ROBIN) ? (_next + k) % count : k;
+			const backend& candidate = _backends[i];
+
+			if (tried[i] || !is_available(candidate, now))
+				continue;
+
+			if (!found) {
+				found = true;
+				selected = i;
+
+				if (_policy != balancing_policy::LEAST_CONNECTIONS)
+					break;
+			}
+			else {
+				const backend& best = _backends[selected];
+
+				if (candidate.active < best.active ||
+					(candidate.active == best.active && candidate.srtt < best.srtt))
+					selected = i;
+			}
+		}
+
+		if (!found) {
+			// All untried backends are put aside, select the one that will
+			// be available first.
+			for (size_t i = 0; i < count; i++) {
+				if (tried[i])
+					continue;
+
+				const int32_t delay = static_cast<int32_t>(_backends[i].retry_time - now);
+				if (!found || delay < static_cast<int32_t>(_backends[selected].retry_time - now)) {
+					found = true;
+					selected = i;
+				}
+			}
+		}
+
+		if (found) {
+			_next = (selected + 1) % count;
+			index = selected;
+		}
+
+		return found;
+	}
+
+
+	void BackendPool::connected(size_t index, uint32_t rtt)
+	{
+		backend& b = _backends[index];
+
+		b.failures = 0;
+		b.active++;
+		b.srtt = (b.srtt == 0) ? std::max(rtt, 1U) : (7 * b.srtt + rtt) / 8;
+
+		LOG_DEBUG(_logger, "backend %s connected rtt=%lu srtt=%lu active=%zu",
+			b.endpoint.to_string().c_str(),
+			rtt,
+			b.srtt,
+			b.active);
+	}
+
+
+	void BackendPool::failed(size_t index)
+	{
+		backend& b = _backends[index];
+
+		const uint32_t delay = std::min(MAX_RETRY_DELAY, MIN_RETRY_DELAY << std::min(b.failures, 4U));
+		b.failures++;
+		b.retry_time = sys_now() + delay;
+
+		if (_backends.size() > 1) {
+			_logger->info(">> backend %s is not responding, retry in %lu s",
+				b.endpoint.to_string().c_str(),
+				delay / 1000);
+		}
+	}
+
+
+	void BackendPool::released(size_t index)
+	{
+		backend& b = _backends[index];
+
+		if (b.active > 0)
+			b.active--;
+	}
+
+
+	bool BackendPool::is_available(const backend& b, uint32_t now) const noexcept
+	{
+		return b.failures == 0 || static_cast<int32_t>(now - b.retry_time) >= 0;
+	}
+
+
+	const char* BackendPool::__class__ = "BackendPool";
+}
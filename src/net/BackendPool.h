@@ -0,0 +1,118 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "net/Endpoint.h"
+#include "util/Logger.h"
+
+
+namespace net {
+
+	// Policies used to select a backend.
+	enum class balancing_policy {
+		FAILOVER,				// The first available backend in the list
+		ROUND_ROBIN,			// Each available backend in turn
+		LEAST_CONNECTIONS		// The available backend having the fewest active connections
+	};
+
+
+	/**
+	* BackendPool: a list of remote endpoints that can serve the same local port.
+	*
+	* The pool selects the backend used by a new forwarder according to a policy
+	* and tracks the health of each backend from the connection results.  A backend
+	* that failed to accept a connection is put aside for a delay that increases
+	* with the number of consecutive failures.  The pool also maintains a smoothed
+	* connection time, used to break ties between backends.
+	*
+	* The pool is not thread safe, it must be accessed from the tunneler thread.
+	*/
+	class BackendPool final
+	{
+	public:
+		/**
+		 * Creates a backend pool.
+		 *
+		 * @param endpoints  The list of backends, it can not be empty.
+		 * @param policy     The selection policy.
+		*/
+		explicit BackendPool(const net::Endpoints& endpoints, balancing_policy policy);
+		~BackendPool();
+
+		/**
+		 * Selects a backend.
+		 *
+		 * Available backends are preferred.  If all untried backends are put aside,
+		 * the one whose retry delay ends first is selected.
+		 *
+		 * @param tried  Flags of the backends already tried by the caller.
+		 * @param index  The index of the selected backend.
+		 *
+		 * @return false if all backends were tried.
+		*/
+		bool select(const std::vector<bool>& tried, size_t& index);
+
+		/**
+		 * Records a successful connection to a backend.
+		 *
+		 * @param index  The backend index.
+		 * @param rtt    The time needed to establish the connection (ms).
+		*/
+		void connected(size_t index, uint32_t rtt);
+
+		/**
+		 * Records a connection failure.
+		*/
+		void failed(size_t index);
+
+		/**
+		 * Records the end of a connection established with a backend.
+		*/
+		void released(size_t index);
+
+		/**
+		 * Returns the endpoint of a backend.
+		*/
+		inline const net::Endpoint& endpoint(size_t index) const { return _backends[index].endpoint; }
+
+		/**
+		 * Returns the number of backends.
+		*/
+		inline size_t size() const noexcept { return _backends.size(); }
+
+	private:
+		// The class name.
+		static const char* __class__;
+
+		// A reference to the application logger.
+		utl::Logger* const _logger;
+
+		struct backend {
+			net::Endpoint endpoint;
+			size_t active;					// number of connected forwarders
+			uint32_t failures;				// number of consecutive failures
+			uint32_t retry_time;			// the backend is put aside until this time
+			uint32_t srtt;					// smoothed connection time (ms), 0 if unknown
+		};
+
+		// The selection policy.
+		const balancing_policy _policy;
+
+		// The backends.
+		std::vector<backend> _backends;
+
+		// Next backend to use with the round robin policy.
+		size_t _next;
+
+		// Returns true if the backend is not put aside.
+		bool is_available(const backend& b, uint32_t now) const noexcept;
+	};
+
+}
@@ -9,6 +9,7 @@
 
 #include <string>
 #include <cstdint>
+#include <vector>
 
 
 namespace net {
@@ -72,4 +73,8 @@ namespace net {
 		void init(const std::string& address, uint16_t default_port);
 	};
 
+
+	// A list of endpoints.
+	using Endpoints = std::vector<Endpoint>;
+
 }
@@ -0,0 +1,131 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "LoopStats.h"
+
+#include <windows.h>
+#include <intrin.h>
+#include <algorithm>
+#include "util/SysUtil.h"
+
+
+namespace net {
+
+	LoopStats::LoopStats() :
+		_buckets(),
+		_count(0),
+		_spin_count(0),
+		_max(0),
+		_start_time(0),
+		_start_cpu(0)
+	{
+	}
+
+
+	void LoopStats::start() noexcept
+	{
+		_buckets.fill(0);
+		_count = 0;
+		_spin_count = 0;
+		_max = 0;
+		_start_time = utl::now_us();
+		_start_cpu = thread_cpu_us();
+	}
+
+
+	void LoopStats::record(uint64_t duration, bool spinning) noexcept
+	{
+		_buckets[bucket_index(duration)]++;
+		_count++;
+		if (spinning)
+			_spin_count++;
+		_max = std::max(_max, duration);
+	}
+
+
+	void LoopStats::report(utl::Logger* logger, utl::LogLevel level) const
+	{
+		if (!logger->is_enabled(level))
+			return;
+
+		const uint64_t elapsed = utl::now_us() - _start_time;
+		const uint64_t cpu = thread_cpu_us() - _start_cpu;
+
+		logger->log(level, ">> tunnel loop cpu=%.1f%% events=%llu spinning=%llu",
+			elapsed > 0 ? 100.0 * cpu / elapsed : 0.0,
+			_count,
+			_spin_count);
+
+		if (_count > 0) {
+			logger->log(level, ">> tunnel loop processing time p50=%llu p90=%llu p99=%llu max=%llu us",
+				percentile(50),
+				percentile(90),
+				percentile(99),
+				_max);
+		}
+	}
+
+
+	size_t LoopStats::bucket_index(uint64_t value) noexcept
+	{
+		if (value < 16)
+			return static_cast<size_t>(value);
+
+		if (value >= (1ULL << 32))
+			return BUCKET_COUNT - 1;
+
+		unsigned long msb;
+		_BitScanReverse(&msb, static_cast<unsigned long>(value));
+		const size_t sub = static_cast<size_t>(value >> (msb - 3)) & 7;
+
+		return 16 + (msb - 4) * 8 + sub;
+	}
+
+
+	uint64_t LoopStats::bucket_value(size_t index) noexcept
+	{
+		if (index < 16)
+			return index;
+
+		const size_t msb = (index - 16) / 8 + 4;
+		const size_t sub = (index - 16) % 8;
+
+		return static_cast<uint64_t>(8 + sub) << (msb - 3);
+	}
+
+
+	uint64_t LoopStats::percentile(unsigned int pct) const noexcept
+	{
+		// Returns the lower bound of the bucket holding the percentile.
+		const uint64_t rank = (_count * pct + 99) / 100;
+		uint64_t total = 0;
+
+		for (size_t i = 0; i < BUCKET_COUNT; i++) {
+			total += _buckets[i];
+			if (total >= rank)
+				return bucket_value(i);
+		}
+
+		return _max;
+	}
+
+
+	uint64_t LoopStats::thread_cpu_us() noexcept
+	{
+		FILETIME creation, exit, kernel, user;
+
+		if (!::GetThreadTimes(::GetCurrentThread(), &creation, &exit, &kernel, &user))
+			return 0;
+
+		const uint64_t k = (static_cast<uint64_t>(kernel.dwHighDateTime) << 32) | kernel.dwLowDateTime;
+		const uint64_t u = (static_cast<uint64_t>(user.dwHighDateTime) << 32) | user.dwLowDateTime;
+
+		// FILETIME is expressed in 100 ns units.
+		return (k + u) / 10;
+	}
+
+}
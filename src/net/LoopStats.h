@@ -0,0 +1,73 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include "util/Logger.h"
+
+
+namespace net {
+
+	/**
+	* LoopStats: measures the cost and the responsiveness of the tunneler loop.
+	*
+	* The loop reports the time spent processing the sockets ready after each
+	* wake-up.  The statistics give the percentiles of this processing time,
+	* the number of wake-ups that occurred while the loop was spinning and the
+	* CPU time consumed by the calling thread.  The wake-up latency itself is
+	* not measured, the CPU time shows the cost of the busy poll mode.
+	*
+	* Durations are stored in a histogram with a relative precision of 12.5%,
+	* the memory footprint is constant.
+	*/
+	class LoopStats final
+	{
+	public:
+		LoopStats();
+
+		/**
+		 * Starts the measurement, the CPU time of the calling thread is sampled.
+		*/
+		void start() noexcept;
+
+		/**
+		 * Records the time spent processing the events of a wake-up.
+		 *
+		 * @param duration The processing time in microseconds.
+		 * @param spinning True if the events were detected while spinning.
+		*/
+		void record(uint64_t duration, bool spinning) noexcept;
+
+		/**
+		 * Writes a summary to the log.
+		*/
+		void report(utl::Logger* logger, utl::LogLevel level) const;
+
+	private:
+		// 16 exact buckets followed by 8 buckets per power of 2 up to 2^32 us.
+		static constexpr size_t BUCKET_COUNT = 16 + 28 * 8;
+
+		std::array<uint32_t, BUCKET_COUNT> _buckets;
+		uint64_t _count;
+		uint64_t _spin_count;
+		uint64_t _max;
+
+		// Wall clock and CPU time at the start of the measurement (us).
+		uint64_t _start_time;
+		uint64_t _start_cpu;
+
+		static size_t bucket_index(uint64_t value) noexcept;
+		static uint64_t bucket_value(size_t index) noexcept;
+		uint64_t percentile(unsigned int pct) const noexcept;
+
+		// Returns the CPU time (user + kernel) consumed by the calling thread (us).
+		static uint64_t thread_cpu_us() noexcept;
+	};
+
+}
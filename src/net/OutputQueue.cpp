@@ -14,7 +14,10 @@ namespace net {
 
 	OutputQueue::OutputQueue(uint16_t capacity) :
 		PBufQueue(capacity),
-		_logger(Logger::get_logger())
+		_logger(Logger::get_logger()),
+		_staging(),
+		_staged(0),
+		_retry_block(false)
 	{
 		DEBUG_CTOR(_logger);
 	}
@@ -26,11 +29,12 @@ namespace net {
 	}
 
 
-	utl::mbed_err OutputQueue::write(net::Socket& socket, size_t& written)
+	utl::mbed_err OutputQueue::write(net::Socket& socket, size_t& written, size_t max_record)
 	{
-		TRACE_ENTER_FMT(_logger, "write to mbedtls socket=0x%012Ix, queue_size=%zu",
+		TRACE_ENTER_FMT(_logger, "write to mbedtls socket=0x%012Ix, queue_size=%zu, max_record=%zu",
 			PTR_VAL(std::addressof(socket)),
-			size()
+			size(),
+			max_record
 		);
 
 		written = 0;
@@ -40,10 +44,32 @@ namespace net {
 			// Get the next contiguous block of data.
 			const PBufQueue::cblock data_cblock{ get_cblock() };
 
-			// Send this block.
-			snd_status = socket.send_data(data_cblock.pdata, data_cblock.len);
+			if (_staged == 0 && !_retry_block && max_record > data_cblock.len && size() > data_cblock.len) {
+				// Coalesce the next blocks.
+				if (_staging.size() < max_record)
+					_staging.resize(max_record);
+				_staged = copy(_staging.data(), max_record);
+			}
 
-			if (snd_status.code == snd_status_code::NETCTX_SND_OK) {
+			// Send the coalesced data or this block.
+			snd_status = _staged > 0
+				? socket.send_data(_staging.data(), _staged)
+				: socket.send_data(data_cblock.pdata, data_cblock.len);
+			_retry_block = _staged == 0 && snd_status.code == snd_status_code::NETCTX_SND_RETRY;
+
+			if (snd_status.code == snd_status_code::NETCTX_SND_OK && _staged > 0) {
+				// Remove the coalesced data from the queue, the remaining data
+				// is coalesced again by the next write.
+				_staged = 0;
+				if (!skip(snd_status.sbytes)) {
+					_logger->error("INTERNAL ERROR: OutputQueue::skip failed");
+					snd_status.code = snd_status_code::NETCTX_SND_ERROR;
+					snd_status.rc = MBEDTLS_ERR_NET_SOCKET_FAILED;
+				}
+				else
+					written += snd_status.sbytes;
+			}
+			else if (snd_status.code == snd_status_code::NETCTX_SND_OK) {
 				// Move the pointer into the queue if bytes have been sent.
 				if (!move(snd_status.sbytes)) {
 					_logger->error("INTERNAL ERROR: OutputQueue::move failed");
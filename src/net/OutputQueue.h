@@ -8,6 +8,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 #include <lwip/tcp.h>
 #include "net/Socket.h"
 #include "util/PBufQueue.h"
@@ -23,7 +24,16 @@ namespace net {
 		explicit OutputQueue(uint16_t capacity);
 		~OutputQueue();
 
-		utl::mbed_err write(net::Socket& socket, size_t& written);
+		/**
+		 * Writes the queued data to a socket.
+		 *
+		 * Each contiguous block is written separately.  When `max_record` is
+		 * larger than the first block, the next blocks are coalesced in a single
+		 * write not larger than `max_record`, a TLS socket sends them in a
+		 * single record.  A coalesced write that must be retried is retried
+		 * with the same data as required by mbedtls.
+		*/
+		utl::mbed_err write(net::Socket& socket, size_t& written, size_t max_record = 0);
 		utl::lwip_err write(struct ::tcp_pcb* socket, size_t& written);
 
 	private:
@@ -32,6 +42,14 @@ namespace net {
 
 		// a reference to the application logger
 		utl::Logger* const _logger;
+
+		// The coalesced data and its size, the size is 0 if no coalesced
+		// write is pending.
+		std::vector<uint8_t> _staging;
+		size_t _staged;
+
+		// True if a write of the first block must be retried.
+		bool _retry_block;
 	};
 
 }
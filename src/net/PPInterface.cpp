@@ -7,8 +7,10 @@
 */
 #include "PPInterface.h"
 
+#include <algorithm>
 #include <array>
 #include <lwip/stats.h>
+#include <lwip/tcp.h>
 #include "util/ErrUtil.h"
 
 
@@ -25,13 +27,15 @@ namespace net {
 	constexpr int PPP_MAXIDLE = 60 * 1000;
 
 
-	PPInterface::PPInterface(net::TlsSocket& tunnel, utl::Counters& counters) :
+	PPInterface::PPInterface(net::TlsSocket& tunnel, utl::Counters& counters, const ppp_config& config) :
 		_logger(Logger::get_logger()),
-		_tunnel(tunnel),
+		_tunnel(&tunnel),
 		_counters(counters),
+		_config(config),
 		_nif(),
 		_pcb(nullptr),
-		_output_queue(32 * 1024)
+		_output_queue(32 * 1024),
+		_record_sizer(config.adaptive_records)
 	{
 		DEBUG_CTOR(_logger);
 	}
@@ -50,7 +54,7 @@ namespace net {
 	{
 		DEBUG_ENTER(_logger);
 
-		if (!_tunnel.is_connected()) {
+		if (!_tunnel->is_connected()) {
 			_logger->error("ERROR: %s - tunnel not connected");
 			return false;
 		}
@@ -62,6 +66,7 @@ namespace net {
 		
 		// initialize lwIP statistics
 		::stats_init();
+		::tcp_batch_stats = {};
 
 		// Create a PPP over the SSLVPN connection.
 		_pcb = ::pppossl_create(&_nif, ppp_output_cb, ppp_link_status_cb, this);
@@ -78,6 +83,9 @@ namespace net {
 		_pcb->lcp_wantoptions.neg_pcompression = false;
 		_pcb->lcp_wantoptions.neg_asyncmap = false;
 
+		// Apply timers and pre-seeded addresses.
+		configure();
+
 		// Start the connection.  The ppp_link_status_cb will be called
 		// by the lwIP stack to report the connection success/failure.
 		const ppp_err rc_con = ::ppp_connect(_pcb, 0);
@@ -99,9 +107,15 @@ namespace net {
 	{
 		DEBUG_ENTER(_logger);
 
-		if (_logger->is_debug_enabled())
+		if (_logger->is_debug_enabled()) {
 			::stats_display();
 
+			_logger->debug("... tcp input batches=%lu segments=%lu acks=%lu",
+				tcp_batch_stats.batches,
+				tcp_batch_stats.segs,
+				tcp_batch_stats.acks);
+		}
+
 		if (!dead()) {
 
 			const ppp_err rc = ::ppp_close(_pcb, nocarrier? 1 : 0);
@@ -133,6 +147,19 @@ namespace net {
 	}
 
 
+	void PPInterface::set_tunnel(net::TlsSocket& tunnel)
+	{
+		DEBUG_ENTER_FMT(_logger, "datagram=%d", tunnel.is_datagram());
+
+		if (_pcb) {
+			_logger->error("INTERNAL ERROR: %s - tunnel replaced on an open interface", __class__);
+			return;
+		}
+
+		_tunnel = &tunnel;
+	}
+
+
 	std::string PPInterface::addr() const
 	{
 		return std::string(::ip4addr_ntoa(netif_ip4_addr(_pcb->netif)));
@@ -175,18 +202,20 @@ namespace net {
 
 		if (!_output_queue.is_empty()) {
 			size_t written = 0;
-			rc = _output_queue.write(_tunnel, written);
+			rc = _output_queue.write(*_tunnel, written, _record_sizer.record_size(sys_now()));
 			LOG_TRACE(_logger, "rc=%d sbytes=%zu", rc, written);
 
 			if (rc == 0) {
 				_counters.sent += written;
+				if (written > 0)
+					_record_sizer.sent(written, sys_now());
 			}
 			else {
 				_logger->error("ERROR: %s - tunnel send failure (%d)", __class__, rc);
 			}
 		}
 
-		LOG_TRACE(_logger, "socket fd=%d rc=%d", _tunnel.get_fd(), rc);
+		LOG_TRACE(_logger, "socket fd=%d rc=%d", _tunnel->get_fd(), rc);
 
 		return rc == 0;
 	}
@@ -196,11 +225,13 @@ namespace net {
 	{
 		TRACE_ENTER(_logger);
 
-		std::array<unsigned char, 4096> buffer = {};
+		// A TLS record holds up to 16 KB, read it at once to process all
+		// its PPP frames in a single input batch.
+		std::array<unsigned char, 16 * 1024> buffer;
 		bool rc;
 
 		// Read data available in the tunnel.
-		const rcv_status status{ _tunnel.recv_data(buffer.data(), buffer.size())};
+		const rcv_status status{ _tunnel->recv_data(buffer.data(), buffer.size())};
 		LOG_TRACE(_logger, "code=%d rc=%d rbytes=%zu",
 			status.code,
 			status.rc,
@@ -212,8 +243,12 @@ namespace net {
 			rc = true;
 			_counters.received += status.rbytes;
 
-			// PPP data available, pass it to the lwIP stack.
+			// PPP data available, pass it to the lwIP stack.  All segments
+			// received in this read are acknowledged together.
+			::tcp_input_batch_begin();
 			const ppp_err ppp_rc = ::pppossl_input(_pcb, buffer.data(), status.rbytes);
+			::tcp_input_batch_end();
+
 			if (ppp_rc) {
 				_logger->error("ERROR: %s - input failure (%s)",
 					__class__,
@@ -241,12 +276,31 @@ namespace net {
 			break;
 		}
 
-		LOG_TRACE(_logger, "socket fd=%d rc=%d", _tunnel.get_fd(), rc);
+		LOG_TRACE(_logger, "socket fd=%d rc=%d", _tunnel->get_fd(), rc);
 
 		return rc;
 	}
 
 
+	bool PPInterface::send_datagram(const struct pbuf* frame)
+	{
+		// pppossl_write allocates each frame in a single pbuf.
+		const snd_status status{ _tunnel->send_data(static_cast<const unsigned char*>(frame->payload), frame->len) };
+
+		if (status.code == snd_status_code::NETCTX_SND_OK) {
+			_counters.sent += status.sbytes;
+			return true;
+		}
+
+		// A datagram that can not be sent is lost, the inner TCP connections
+		// retransmit it.
+		if (status.code == snd_status_code::NETCTX_SND_ERROR)
+			_logger->error("ERROR: %s - tunnel send failure (%d)", __class__, status.rc);
+
+		return false;
+	}
+
+
 	void PPInterface::send_keep_alive()
 	{
 		if (_pcb && (_pcb->lcp_fsm.state == PPP_FSM_OPENED) && (sys_now() - last_xmit() > PPP_MAXIDLE)) {
@@ -255,6 +309,41 @@ namespace net {
 	}
 
 
+	void PPInterface::configure()
+	{
+		_pcb->settings.fsm_timeout_time = std::max<uint8_t>(_config.restart_timeout, 1);
+		_pcb->settings.fsm_max_conf_req_transmits = std::max<uint8_t>(_config.max_configure, 1);
+
+		if (_config.skip_rx_checksum) {
+			// Checksums are still generated on output.
+			NETIF_SET_CHECKSUM_CTRL(&_nif,
+				NETIF_CHECKSUM_GEN_IP | NETIF_CHECKSUM_GEN_UDP | NETIF_CHECKSUM_GEN_TCP | NETIF_CHECKSUM_GEN_ICMP);
+		}
+
+		if (!_config.seed_addresses)
+			return;
+
+		ip4_addr_t addr;
+		if (!_config.local_addr.empty() && ::ip4addr_aton(_config.local_addr.c_str(), &addr)) {
+			ppp_set_ipcp_ouraddr(_pcb, &addr);
+
+			// The peer can still assign another address.
+			_pcb->ipcp_wantoptions.accept_local = true;
+		}
+
+		for (size_t i = 0; i < std::min<size_t>(_config.dns_addrs.size(), 2); i++) {
+			if (::ip4addr_aton(_config.dns_addrs[i].c_str(), &addr))
+				_pcb->ipcp_wantoptions.dnsaddr[i] = ip4_addr_get_u32(&addr);
+		}
+
+		LOG_DEBUG(_logger, "timeout=%us max_configure=%u addr=%s dns=%zu",
+			_pcb->settings.fsm_timeout_time,
+			_pcb->settings.fsm_max_conf_req_transmits,
+			_config.local_addr.c_str(),
+			_config.dns_addrs.size());
+	}
+
+
 	int PPInterface::last_xmit() const
 	{
 		auto pcbssl = static_cast<const pppossl_pcb *>(_pcb->link_ctx_cb);
@@ -268,6 +357,10 @@ namespace net {
 		LWIP_UNUSED_ARG(pcb);
 		auto pp_interface = static_cast<PPInterface *>(ctx);
 
+		// Over DTLS, each frame is sent immediately in its own datagram.
+		if (pp_interface->_tunnel->is_datagram())
+			return pp_interface->send_datagram(pbuf) ? pbuf->tot_len : 0;
+
 		return pp_interface->_output_queue.push(pbuf) ? pbuf->tot_len : 0;
 	}
 
@@ -8,22 +8,45 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <lwip/arch.h>
 #include <lwip/pbuf.h>
 #include <lwip/netif.h>
 #include "net/pppossl.h"
 #include "net/TlsSocket.h"
 #include "net/OutputQueue.h"
+#include "net/RecordSizer.h"
 #include "util/Logger.h"
 #include "util/Counters.h"
 
 
 namespace net {
 
+	struct ppp_config {
+		// LCP/IPCP restart timer (in seconds) and maximum number of
+		// Configure-Request transmissions.
+		uint8_t restart_timeout = 3;
+		uint8_t max_configure = 10;
+
+		// Addresses assigned by the portal.  When specified, they are sent in
+		// the first IPCP Configure-Request, saving a Configure-Nak round trip.
+		bool seed_addresses = true;
+		std::string local_addr;
+		std::vector<std::string> dns_addrs;
+
+		// Do not verify the checksums of the received packets.  The tunnel is
+		// protected by TLS, a corrupted packet can not be received.
+		bool skip_rx_checksum = false;
+
+		// Coalesce the queued PPP frames in larger TLS records once a burst
+		// of data is sent, see RecordSizer.
+		bool adaptive_records = true;
+	};
+
 	class PPInterface final
 	{
 	public:
-		explicit PPInterface(net::TlsSocket& tunnel, utl::Counters& counters);
+		explicit PPInterface(net::TlsSocket& tunnel, utl::Counters& counters, const ppp_config& config);
 		~PPInterface();
 
 		/**
@@ -31,6 +54,13 @@ namespace net {
 		*/
 		bool open();
 
+		/**
+		 * Replaces the socket connected to the firewall.
+		 *
+		 * The function must be called before the interface is opened.
+		*/
+		void set_tunnel(net::TlsSocket& tunnel);
+
 		/**
 		 * Initiates the end of the PPP over SSL interface.
 		*/
@@ -113,6 +143,16 @@ namespace net {
 		*/
 		int last_xmit() const;
 
+		/**
+		 * Sends a PPP frame in a DTLS datagram.
+		*/
+		bool send_datagram(const struct pbuf* frame);
+
+		/**
+		 * Applies the negotiation parameters to the control block.
+		*/
+		void configure();
+
 		// The class name
 		static const char* __class__;
 
@@ -120,11 +160,14 @@ namespace net {
 		utl::Logger* const _logger;
 
 		// socket connected to the firewall.
-		net::TlsSocket&  _tunnel;
+		net::TlsSocket*  _tunnel;
 
 		// Counters of bytes sent to / received from the tunnel.
 		utl::Counters& _counters;
 
+		// PPP negotiation parameters.
+		const ppp_config _config;
+
 		// The lwIP network interface and the control block.  Received 
 		// data are passed to that interface.
 		struct ::netif _nif;
@@ -133,6 +176,9 @@ namespace net {
 		// The output queue.  All data in this queue are sent
 		// through the tunnel. 
 		net::OutputQueue _output_queue;
+
+		// Selects the size of the records sent in the tunnel.
+		net::RecordSizer _record_sizer;
 	};
 
 }
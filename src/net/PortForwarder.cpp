@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <array>
 #include <lwip/err.h>
+#include <lwip/sys.h>
 #include <lwip/timeouts.h>
 #include <lwip/tcp.h>
 #include "net/DnsClient.h"
@@ -27,22 +28,37 @@ namespace net {
 	err_t tcp_sent_cb(void* arg, tcp_pcb* tpcb, u16_t len);
 	err_t tcp_recv_cb(void* arg, tcp_pcb* tpcb, pbuf* p, err_t err);
 	void timeout_cb(void* arg);
+	void ack_timer_cb(void* arg);
 
+	// The quick acknowledgment budget is restored after this idle time (ms).
+	static constexpr uint32_t ACK_IDLE_TIME = 500;
 
-	PortForwarder::PortForwarder(const net::Endpoint& endpoint, bool tcp_nodelay, bool keepalive) :
+
+	PortForwarder::PortForwarder(BackendPool& backends, const forwarder_config& config,
+		TrafficShaper& tunnel_shaper) :
 		_logger(Logger::get_logger()),
 		_state(State::READY),
-		_endpoint(endpoint),
-		_tcp_nodelay(tcp_nodelay),
-		_keepalive(keepalive),
+		_backends(backends),
+		_backend(0),
+		_tried(backends.size(), false),
+		_backend_active(false),
+		_connect_start(0),
+		_config(config),
 		_local_server(),
 		_local_client(nullptr),
 		_connect_timeout(false),
+		_connect_error(false),
+		_dns_pending(false),
 		_fflush_timeout(false),
 		_rflush_timeout(false),
 		_reply_queue(8 * 1024),
 		_forward_queue(8 * 1024),
-		_forwarded_bytes(0)
+		_forwarded_bytes(0),
+		_shaper(config.rates, &tunnel_shaper),
+		_unacked_bytes(0),
+		_last_recv(0),
+		_quick_acks(config.quick_acks),
+		_ack_timer(false)
 	{
 		DEBUG_CTOR(_logger);
 	}
@@ -56,14 +72,18 @@ namespace net {
 		sys_untimeout(timeout_cb, &_connect_timeout);
 		sys_untimeout(timeout_cb, &_fflush_timeout);
 		sys_untimeout(timeout_cb, &_rflush_timeout);
+		sys_untimeout(ack_timer_cb, this);
+
+		if (_backend_active)
+			_backends.released(_backend);
 	}
 
 
-	bool PortForwarder::connect(net::Listener& listener)
+	bool PortForwarder::accept(net::Listener& listener)
 	{
 		DEBUG_ENTER(_logger);
 
-		if (_state != State::READY) {
+		if (_state != State::READY || _local_server.is_connected()) {
 			_logger->error("ERROR: forwarder %d not in READY state", get_fd());
 			return false;
 		}
@@ -82,73 +102,147 @@ namespace net {
 		}
 
 		// Disable Nagle algorithm on the local server.
-		_local_server.set_nodelay(_tcp_nodelay);
-
-		// Resolve the end point host name to an IP address.  The DNS request
-		// is sent to the FortiGate firewall and is asynchronous.  dns_found_cb is 
-		// called when the host name is resolved or if the resolution fails.
-		ip_addr_t addr;
-		const lwip_err rc_query = DnsClient::query(_endpoint.hostname(), addr, dns_found_cb, this);
-		if (rc_query == ERR_OK || rc_query == ERR_INPROGRESS) {
-			// host name is already resolved or not yet resolved.
-			_state = State::CONNECTING;
-		}
-		else if (rc_query == ERR_VAL) {
-			// DNS server is not configured, abort the connection.
-			_state = State::FAILED;
-			_logger->error("ERROR: %s 0x%012Ix - can not resolve %s",
-				__class__,
-				PTR_VAL(this),
-				_endpoint.hostname().c_str()
-			);
-		}
-		else {
-			// There was an error during name resolution, abort the connection.
-			_state = State::FAILED;
-			_logger->error("ERROR: %s 0x%012Ix - DNS error (%s)",
-				__class__,
-				PTR_VAL(this),
-				lwip_errmsg(rc_query).c_str()
-			);
-		}
+		_local_server.set_nodelay(_config.tcp_nodelay);
 
-		if (_state == State::FAILED)
-			return false;
+		return true;
+	}
 
-		// Allocate the TCP client.
-		_local_client = tcp_new();
-		if (!_local_client) {
-			_logger->error("ERROR: %s 0x%012Ix - tcp_new memory allocation failure",
-				__class__,
-				PTR_VAL(this)
-			);
 
-			_state = State::FAILED;
+	bool PortForwarder::connect()
+	{
+		DEBUG_ENTER(_logger);
+
+		if (!is_pending()) {
+			_logger->error("ERROR: forwarder %d not in READY state", get_fd());
 			return false;
 		}
 
-		// Set TCP_NODELAY inside the tunnel
-		if (_tcp_nodelay)
-			tcp_nagle_disable(_local_client);
+		return connect_backend();
+	}
+
+
+	bool PortForwarder::failover()
+	{
+		DEBUG_ENTER(_logger);
+
+		if (_state != State::CONNECTING)
+			return false;
 
-		if (_keepalive) {
-			// Turn on TCP keep alive
-			ip_set_option(_local_client, SOF_KEEPALIVE);
+		sys_untimeout(timeout_cb, &_connect_timeout);
 
-			// Peer is considered dead when keep_idle + (keep_intvl * keep_cnt) = 180 s
-			// expires without any response from the pear.  When the peer is considered
-			// dead, the lwIP library calls tcp_err_cb callback.
-			_local_client->keep_idle = 30000;		// 30 sec
-			_local_client->keep_intvl = 20000;		// 20 sec
-			_local_client->keep_cnt = 6;			// 6 probes
+		if (_connect_timeout) {
+			_logger->error("ERROR: timeout, can't connect to %s", endpoint().to_string().c_str());
 		}
 
-		if (rc_query == ERR_OK) {
-			// Host name is resolved.
-			dns_found_cb(_endpoint.hostname().c_str(), &addr, this);
+		// Release the TCP PCB.  Callbacks are removed first, we are not
+		// interested to be called when the connection is aborted.
+		if (_local_client) {
+			::tcp_arg(_local_client, nullptr);
+			::tcp_err(_local_client, nullptr);
+			::tcp_sent(_local_client, nullptr);
+			::tcp_recv(_local_client, nullptr);
+			::tcp_abort(_local_client);
+			_local_client = nullptr;
 		}
 
-		return true;
+		_backends.failed(_backend);
+
+		return connect_backend();
+	}
+
+
+	bool PortForwarder::connect_backend()
+	{
+		while (_backends.select(_tried, _backend)) {
+			_tried[_backend] = true;
+			_connect_timeout = false;
+			_connect_error = false;
+
+			LOG_DEBUG(_logger, "0x%012Ix connecting to %s",
+				PTR_VAL(this),
+				endpoint().to_string().c_str());
+
+			// Resolve the end point host name to an IP address.  The DNS request
+			// is sent to the FortiGate firewall and is asynchronous.  dns_found_cb is 
+			// called when the host name is resolved or if the resolution fails.
+			ip_addr_t addr;
+			const lwip_err rc_query = DnsClient::query(endpoint().hostname(), addr, dns_found_cb, this);
+			if (rc_query == ERR_VAL) {
+				// DNS server is not configured, this backend can't be used.
+				_logger->error("ERROR: %s 0x%012Ix - can not resolve %s",
+					__class__,
+					PTR_VAL(this),
+					endpoint().hostname().c_str()
+				);
+
+				_backends.failed(_backend);
+				continue;
+			}
+			else if (rc_query != ERR_OK && rc_query != ERR_INPROGRESS) {
+				// There was an error during name resolution, try the next backend.
+				_logger->error("ERROR: %s 0x%012Ix - DNS error (%s)",
+					__class__,
+					PTR_VAL(this),
+					lwip_errmsg(rc_query).c_str()
+				);
+
+				_backends.failed(_backend);
+				continue;
+			}
+
+			// host name is already resolved or not yet resolved.
+			_state = State::CONNECTING;
+			_dns_pending = (rc_query == ERR_INPROGRESS);
+
+			// Allocate the TCP client.
+			_local_client = tcp_new();
+			if (!_local_client) {
+				_logger->error("ERROR: %s 0x%012Ix - tcp_new memory allocation failure",
+					__class__,
+					PTR_VAL(this)
+				);
+
+				break;
+			}
+
+			// Set TCP_NODELAY inside the tunnel
+			if (_config.tcp_nodelay)
+				tcp_nagle_disable(_local_client);
+
+			// The tunnel never loses a segment, do not collapse the congestion
+			// window and do not retransmit before the tunnel had a chance to deliver.
+			if (_config.rto_min > 0)
+				tcp_set_tunnel_mode(_local_client, _config.rto_min);
+
+			if (_config.keepalive) {
+				// Turn on TCP keep alive
+				ip_set_option(_local_client, SOF_KEEPALIVE);
+
+				// Peer is considered dead when keep_idle + (keep_intvl * keep_cnt) = 180 s
+				// expires without any response from the pear.  When the peer is considered
+				// dead, the lwIP library calls tcp_err_cb callback.
+				_local_client->keep_idle = 30000;		// 30 sec
+				_local_client->keep_intvl = 20000;		// 20 sec
+				_local_client->keep_cnt = 6;			// 6 probes
+			}
+
+			if (rc_query == ERR_OK) {
+				// Host name is resolved.
+				dns_found_cb(endpoint().hostname().c_str(), &addr, this);
+			}
+			else {
+				// The connection timeout includes the name resolution.
+				::sys_timeout(_config.connect_timeout, timeout_cb, &_connect_timeout);
+			}
+
+			return true;
+		}
+
+		// No backend is able to accept the connection.
+		_state = State::FAILED;
+		_local_server.close();
+
+		return false;
 	}
 
 
@@ -194,8 +288,14 @@ namespace net {
 		// Abort the connection by sending a RST (reset) segment to the remote host.
 		// The TCP PCB is de-allocated, the function tcp_err_cb is called which
 		// finally set the current state to DISCONNECTED.
-		::tcp_abort(_local_client);
-		_local_client = nullptr;
+		if (_local_client) {
+			::tcp_abort(_local_client);
+			_local_client = nullptr;
+		}
+		else {
+			// The connection to a backend failed and the PCB is already released.
+			_state = State::DISCONNECTED;
+		}
 
 		// Clear all queues
 		_forward_queue.clear();
@@ -212,10 +312,14 @@ namespace net {
 
 		std::array<unsigned char, 2048> incoming_data = {};
 
-		const size_t available_space = std::min(incoming_data.size(), _forward_queue.remaining_space());
+		const size_t available_space = std::min({ 
+			incoming_data.size(), 
+			_forward_queue.remaining_space(), 
+			_shaper.upload_quota()
+		});
 		if (available_space == 0) {
 			// There is no space in the queue to store data that could be
-			// available in the socket.
+			// available in the socket or the upload rate limit is reached.
 			return true;
 		}
 
@@ -226,6 +330,7 @@ namespace net {
 
 		// The number of bytes received is less than 2048, so the cast is safe.
 		const u16_t length = static_cast<u16_t>(status.rbytes);
+		_shaper.consume_upload(length);
 		pbuf* const buffer = ::pbuf_alloc(PBUF_RAW, length, PBUF_RAM);
 		if (!buffer) {
 			_logger->error("ERROR: %s 0x%012Ix - pbuf memory allocation error",
@@ -301,6 +406,11 @@ namespace net {
 				mbed_errmsg(rc).c_str()
 			);
 		}
+		else if (_ack_timer && _reply_queue.is_empty()) {
+			// The local client consumed everything, the remote endpoint is
+			// probably waiting for an acknowledgment before sending more.
+			flush_ack();
+		}
 
 		return rc == 0;
 	}
@@ -329,6 +439,11 @@ namespace net {
 			// Useful only in case of error or timeout
 			_forward_queue.clear();
 
+			LOG_DEBUG(_logger, "forwarder 0x%012Ix retransmitted %lu segments (%lu bytes)",
+				PTR_VAL(this),
+				tcp_rexmit_segs(_local_client),
+				tcp_rexmit_bytes(_local_client));
+
 			// Remove all callbacks.  We are not interested to be called on such events.
 			::tcp_err(_local_client, nullptr);
 			::tcp_recv(_local_client, nullptr);
@@ -375,21 +490,90 @@ namespace net {
 	}
 
 
+	void PortForwarder::schedule_ack()
+	{
+		if (_config.ack_delay == 0)
+			return;
+
+		// Restore the quick acknowledgment budget after an idle period, the
+		// first segments of a new exchange are acknowledged immediately.
+		const uint32_t now = sys_now();
+		if (now - _last_recv > ACK_IDLE_TIME)
+			_quick_acks = _config.quick_acks;
+		_last_recv = now;
+
+		if (_quick_acks > 0) {
+			// The acknowledgment is sent by tcp_input when the segment is processed.
+			_quick_acks--;
+			tcp_set_flags(_local_client, TF_ACK_NOW);
+		}
+		else if (!_ack_timer) {
+			_ack_timer = true;
+			sys_timeout(_config.ack_delay, ack_timer_cb, this);
+		}
+	}
+
+
+	void PortForwarder::flush_ack()
+	{
+		if (_ack_timer) {
+			sys_untimeout(ack_timer_cb, this);
+			_ack_timer = false;
+		}
+
+		if (_state == State::CONNECTED && (_local_client->flags & TF_ACK_DELAY)) {
+			tcp_set_flags(_local_client, TF_ACK_NOW);
+			::tcp_output(_local_client);
+		}
+	}
+
+
+	void PortForwarder::shape()
+	{
+		_shaper.refill();
+		update_receive_window();
+	}
+
+
+	void PortForwarder::update_receive_window()
+	{
+		if (!_local_client || _unacked_bytes == 0)
+			return;
+
+		// Delaying tcp_recved shrinks the receive window announced to the remote
+		// host which is thus forced to slow down.  No data is dropped.
+		size_t len = std::min(_unacked_bytes, _shaper.download_quota());
+		_shaper.consume_download(len);
+		_unacked_bytes -= len;
+
+		while (len > 0) {
+			const u16_t chunk = static_cast<u16_t>(std::min<size_t>(len, 0xFFFF));
+			::tcp_recved(_local_client, chunk);
+			len -= chunk;
+		}
+	}
+
+
 	void dns_found_cb(const char *name, const ip_addr_t *ipaddr, void *callback_arg)
 	{
 		auto pf = static_cast<PortForwarder*>(callback_arg);
 
-		if (pf->_endpoint.hostname().compare(name) != 0) {
-			pf->_state = PortForwarder::State::FAILED;
-			pf->_logger->error(
-				"ERROR: DNS response for wrong host name %s",
+		if (!pf->is_connecting() || pf->endpoint().hostname().compare(name) != 0) {
+			// This response was requested for a backend that has been abandoned.
+			pf->_logger->debug(
+				"... 0x%012Ix PortForwarder ignore DNS response for host name %s",
+				PTR_VAL(pf),
 				name);
 
 			return;
 		}
 
+		// The connection timer is already armed if the resolution was pending.
+		const bool timer_armed = pf->_dns_pending;
+		pf->_dns_pending = false;
+
 		if (ipaddr == nullptr) {
-			pf->_state = PortForwarder::State::FAILED;
+			pf->_connect_error = true;
 			pf->_logger->error(
 				"ERROR: can not resolve host %s, DNS query failed",
 				name);
@@ -397,10 +581,12 @@ namespace net {
 			return;
 		}
 
-		lwip_err rc_con = ::tcp_connect(pf->_local_client, ipaddr, pf->_endpoint.port(), tcp_connected_cb);
+		lwip_err rc_con = ::tcp_connect(pf->_local_client, ipaddr, pf->endpoint().port(), tcp_connected_cb);
 		if (rc_con == ERR_OK) {
 			// Start a connection timer
-			::sys_timeout(10 * 1000, timeout_cb, &pf->_connect_timeout);
+			pf->_connect_start = sys_now();
+			if (!timer_armed)
+				::sys_timeout(pf->_config.connect_timeout, timeout_cb, &pf->_connect_timeout);
 
 			// Configure the callbacks
 			::tcp_arg(pf->_local_client, pf);
@@ -409,17 +595,11 @@ namespace net {
 			::tcp_recv(pf->_local_client, tcp_recv_cb);
 		}
 		else {
-			pf->_state = PortForwarder::State::FAILED;
+			// The TCP PCB is released when the forwarder fails over.
+			pf->_connect_error = true;
 
 			pf->_logger->error("ERROR: forward - %s",
-				pf,
 				lwip_errmsg(rc_con).c_str());
-
-			// Delete the TCP PCB.
-			::tcp_close(pf->_local_client);
-
-			// Close the local server socket.
-			pf->_local_server.close();
 		}
 	}
 
@@ -440,6 +620,10 @@ namespace net {
 		sys_untimeout(timeout_cb, &pf->_connect_timeout);
 		pf->_connect_timeout = false;
 
+		// Report the connection time to the backend pool.
+		pf->_backends.connected(pf->_backend, sys_now() - pf->_connect_start);
+		pf->_backend_active = true;
+
 		return ERR_OK;
 	}
 
@@ -451,12 +635,21 @@ namespace net {
 		Logger* logger = pf->_logger;
 		logger->debug("... 0x%012Ix PortForwarder TCP error err=%d", PTR_VAL(pf), err);
 
+		if (pf->_state == PortForwarder::State::CONNECTING) {
+			// The backend refused the connection.  The TCP PCB is already
+			// deallocated, the tunneler will fail over to the next backend.
+			logger->error("ERROR: can't connect to %s (%s)",
+				pf->endpoint().to_string().c_str(),
+				lwip_errmsg(err).c_str());
+
+			pf->_local_client = nullptr;
+			pf->_connect_error = true;
+
+			return;
+		}
+
 		if (err != ERR_OK) {
-			if (pf->_state == PortForwarder::State::DISCONNECTING && pf->_connect_timeout) {
-				logger->error("ERROR: timeout, can't connect to %s", 
-					pf->_endpoint.to_string().c_str());
-			}
-			else if (pf->_state != PortForwarder::State::DISCONNECTING) {
+			if (pf->_state != PortForwarder::State::DISCONNECTING) {
 				logger->error("ERROR: %s", lwip_errmsg(err).c_str());
 			}
 		}
@@ -507,8 +700,11 @@ namespace net {
 					rc = ERR_MEM;
 				}
 				else {
-					// len bytes have been received
-					::tcp_recved(tpcb, len);
+					// len bytes have been received, the window is updated according
+					// to the download rate limit.
+					pf->_unacked_bytes += len;
+					pf->update_receive_window();
+					pf->schedule_ack();
 
 					// the buffer is now in the queue, we can free it.
 					::pbuf_free(p);
@@ -556,5 +752,15 @@ namespace net {
 	}
 
 
+	void ack_timer_cb(void* arg)
+	{
+		auto pf = static_cast<PortForwarder*>(arg);
+
+		// The timer is no longer armed, sys_untimeout is thus useless.
+		pf->_ack_timer = false;
+		pf->flush_ack();
+	}
+
+
 	const char* PortForwarder::__class__ = "PortForwarder";
 }
@@ -7,44 +7,79 @@
 */
 #pragma once
 
+#include <cstdint>
+#include <vector>
 #include <lwip/tcp.h>
+#include "net/BackendPool.h"
 #include "net/TcpSocket.h"
 #include "net/Listener.h"
 #include "net/Endpoint.h"
 #include "net/OutputQueue.h"
+#include "net/TrafficShaper.h"
 #include "util/Logger.h"
 
 
 namespace net {
+
+	struct forwarder_config {
+		bool tcp_nodelay;				// disables the Nagle algorithm
+		bool keepalive;					// enables TCP keep alive inside the tunnel
+		uint32_t connect_timeout;		// connection timeout to a backend (ms)
+		shaping_rates rates;			// rate limits of the forwarder
+		uint32_t rto_min;				// lower bound of the RTO inside the tunnel (ms), 
+										// 0 disables the TCP over TCP aware mode
+		uint32_t ack_delay;				// delay of the acknowledgments (ms), 0 keeps
+										// the lwIP delayed acknowledgment
+		uint32_t quick_acks;			// segments acknowledged immediately after an idle period
+	};
+
 	/**
 	* PortForwarder: A class responsible for handling TCP port forwarding. It
 	* accepts local client connections, resolves destination host names, forwards
 	* data between local and remote endpoints, and manages connection states and
-	* timeouts.
+	* timeouts.  The remote endpoint is selected from a backend pool, if a backend
+	* does not respond, the forwarder fails over to the next one.
 	*/
 
 	class PortForwarder final {
 	public:
-		explicit PortForwarder(const net::Endpoint& endpoint, bool tcp_nodelay, bool keepalive);
+		/**
+		 * Creates a port forwarder.
+		 *
+		 * @param backends      The pool of remote endpoints, it must outlive this forwarder.
+		 * @param config        The forwarder configuration.
+		 * @param tunnel_shaper The tunnel wide shaper, it must outlive this forwarder.
+		*/
+		explicit PortForwarder(BackendPool& backends, const forwarder_config& config,
+			TrafficShaper& tunnel_shaper);
 		~PortForwarder();
 
 		/**
-		 * Establishes a connection using the provided listener.
+		 * Accepts a connection from a local client using the provided listener.
 		 *
-		 * This function initiates a connection from a local client to a remote endpoint
-		 * through a listener. It handles accepting incoming connections, resolving the
-		 * endpoint's host name to an IP address, and setting up the TCP client for
-		 * communication. Additionally, it configures various TCP options like TCP_NODELAY
-		 * and keep-alive, if specified.
+		 * The forwarder remains in the READY state until connect is called. 
 		 *
 		 * @param listener Reference to a `Listener` object that is bound to a local
 		 *                 endpoint and waiting for incoming connections.
 		 *
+		 * @return bool Returns `true` if the connection is accepted.
+		 */
+		bool accept(net::Listener& listener);
+
+		/**
+		 * Establishes a connection with a remote endpoint.
+		 *
+		 * This function initiates a connection from the accepted local client to a
+		 * remote endpoint. It handles resolving the endpoint's host name to an IP 
+		 * address, and setting up the TCP client for communication. Additionally, 
+		 * it configures various TCP options like TCP_NODELAY and keep-alive, if 
+		 * specified.
+		 *
 		 * @return bool Returns `true` if the connection setup is successfully initiated,
 		 *              or `false` if an error occurs at any stage.
 		 *
 		 */
-		bool connect(net::Listener& listener);
+		bool connect();
 		
 		/**
 		 * Disconnects this forwarder from the server.
@@ -62,6 +97,12 @@ namespace net {
 		*/
 		void abort();
 
+		/**
+		 * Returns true if a local client is accepted and waits for the 
+		 * connection to a remote endpoint.
+		*/
+		inline bool is_pending() const noexcept { return _state == State::READY && _local_server.is_connected(); }
+
 		/**
 		 * Returns true if this forwarder is connected.
 		*/
@@ -73,9 +114,18 @@ namespace net {
 		inline bool is_connecting() const noexcept { return _state == State::CONNECTING; }
 
 		/**
-		 * Returns true if the connection has timed out.
+		 * Returns true if the connection to the current backend has timed out or failed.
+		*/
+		inline bool has_connection_failed() const noexcept { 
+			return is_connecting() && (_connect_timeout || _connect_error);
+		}
+
+		/**
+		 * Abandons the connection to the current backend and tries the next one.
+		 *
+		 * @return false if no backend is left, the forwarder is then in the FAILED state.
 		*/
-		inline bool has_connection_timed_out() const noexcept { return is_connecting() && _connect_timeout; }
+		bool failover();
 
 		/**
 		 * Returns true if this forwarder is in the disconnecting phase.
@@ -93,9 +143,12 @@ namespace net {
 		inline bool is_disconnected() const noexcept { return _state == State::DISCONNECTED; }
 
 		/**
-		 * Returns true if this forwarder has space in the forward queue.
+		 * Returns true if this forwarder has space in the forward queue and
+		 * if the upload rate limit is not reached.
 		*/
-		inline bool can_receive_data() const noexcept { return !_forward_queue.is_full(); }
+		inline bool can_receive_data() const noexcept { 
+			return !_forward_queue.is_full() && _shaper.upload_quota() > 0;
+		}
 
 		/**
 		 * Returns true if this forwarder has data in the forward queue and
@@ -157,6 +210,12 @@ namespace net {
 		*/
 		void flush_reply_queue();
 
+		/**
+		 * Refills the token buckets of this forwarder and opens the TCP receive
+		 * window for data delayed by the download rate limit.
+		*/
+		void shape();
+
 	private:
 		// The class name
 		static const char* __class__;
@@ -190,6 +249,9 @@ namespace net {
 		// A callback for receiving data from the remote endpoint.
 		friend err_t tcp_recv_cb(void *arg, struct tcp_pcb *tpcb, struct pbuf *p, err_t err);
 
+		// A callback when the delayed acknowledgment timer expires.
+		friend void ack_timer_cb(void *arg);
+
 		// Returns the available tcp buffer queue space for sending (in bytes).
 		inline size_t tcp_snd_buffer_size() const noexcept { return tcp_sndbuf(_local_client); }
 
@@ -199,20 +261,46 @@ namespace net {
 		// Returns true if the tcp queue has unsent segments.
 		inline bool has_pending_tcp_segment() const noexcept { return _local_client->unsent != nullptr; }
 
+		// Selects a backend and starts the connection.
+		bool connect_backend();
+
+		// Returns the endpoint of the current backend.
+		inline const net::Endpoint& endpoint() const { return _backends.endpoint(_backend); }
+
+		// Informs lwIP that received data has been processed as long as the 
+		// download quota allows it.
+		void update_receive_window();
+
+		// Acknowledges the received data immediately or arms the delayed
+		// acknowledgment timer.
+		void schedule_ack();
+
+		// Sends a pending delayed acknowledgment.
+		void flush_ack();
+
 		// A reference to the application logger.
 		utl::Logger* const _logger;
 
 		// The current state of the forwarder.
 		State _state;
 
-		// The end point this forwarder is connected to.
-		const net::Endpoint _endpoint;
+		// The pool of remote end points.
+		BackendPool& _backends;
+
+		// The index of the current backend.
+		size_t _backend;
 
-		// True if TCP no delay mode is enabled.
-		const bool _tcp_nodelay;
+		// Backends already tried by this forwarder.
+		std::vector<bool> _tried;
 
-		// The keep alive is enabled.
-		const bool _keepalive;
+		// True if this forwarder is counted as an active connection of the backend.
+		bool _backend_active;
+
+		// Time when the connection to the current backend was started.
+		uint32_t _connect_start;
+
+		// The forwarder configuration.
+		const forwarder_config _config;
 
 		// The local endpoint acting as a server.
 		net::TcpSocket _local_server;
@@ -223,6 +311,13 @@ namespace net {
 		// Indicates whether the connection timer has expired.
 		bool _connect_timeout;
 
+		// Indicates whether the connection to the current backend failed.
+		bool _connect_error;
+
+		// Indicates whether a DNS resolution is pending, the connection timer
+		// is then armed before the host name is resolved.
+		bool _dns_pending;
+
 		// Indicates whether the forward flush timer has expired.
 		bool _fflush_timeout;
 
@@ -243,6 +338,22 @@ namespace net {
 
 		// Number of bytes in transit (sent to the remote endpoint)
 		size_t _forwarded_bytes;
+
+		// The rate limiter of this forwarder.
+		TrafficShaper _shaper;
+
+		// Number of bytes received from the remote endpoint but not yet
+		// acknowledged with tcp_recved.  
+		size_t _unacked_bytes;
+
+		// Time when data was last received from the remote endpoint.
+		uint32_t _last_recv;
+
+		// Number of segments that can still be acknowledged immediately.
+		uint32_t _quick_acks;
+
+		// Indicates whether the delayed acknowledgment timer is armed.
+		bool _ack_timer;
 	};
 
 }
@@ -62,15 +62,29 @@ namespace net {
 	}
 
 
-	bool PortForwarders::has_connecting_forwarders() const noexcept
+	size_t PortForwarders::connecting_count() const noexcept
 	{
+		size_t counter = 0;
 		for (const auto* pf : *this) {
 			if (pf && pf->is_connecting()) {
-				return true;
+				counter++;
+			}
+		}
+
+		return counter;
+	}
+
+
+	size_t PortForwarders::pending_count() const noexcept
+	{
+		size_t counter = 0;
+		for (const auto* pf : *this) {
+			if (pf && pf->is_pending()) {
+				counter++;
 			}
 		}
 
-		return false;
+		return counter;
 	}
 
 
@@ -43,10 +43,15 @@ namespace net {
 		*/
 		size_t abort_all() const;
 
-		/*
-		 * Returns true if at least one port forwarder is trying to connect.
+		/**
+		 * Returns the number of forwarders trying to connect.
+		*/
+		size_t connecting_count() const noexcept;
+
+		/**
+		 * Returns the number of forwarders waiting to connect.
 		*/
-		bool has_connecting_forwarders() const noexcept;
+		size_t pending_count() const noexcept;
 
 		/**
 		 * Returns the number of connected forwarders.
@@ -0,0 +1,65 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "RecordSizer.h"
+
+
+namespace net {
+
+	// Maximum payload of a TLS record.
+	static constexpr size_t FULL_RECORD_SIZE = 16384;
+
+	// Full records are sent while more than RAMP_BYTES are sent during a
+	// window of RATE_WINDOW ms (about 2.6 Mbit/s).
+	static constexpr size_t RAMP_BYTES = 64 * 1024;
+	static constexpr uint32_t RATE_WINDOW = 200;
+
+
+	RecordSizer::RecordSizer(bool enabled) noexcept :
+		_enabled(enabled),
+		_window_bytes(0),
+		_previous_bytes(0),
+		_window_start(0)
+	{
+	}
+
+
+	size_t RecordSizer::record_size(uint32_t now) noexcept
+	{
+		if (!_enabled)
+			return 0;
+
+		update_window(now);
+
+		// The frames of an interactive session are not coalesced, each frame
+		// is sent in its own record.
+		const bool bulk = _window_bytes >= RAMP_BYTES || _previous_bytes >= RAMP_BYTES;
+
+		return bulk ? FULL_RECORD_SIZE : 0;
+	}
+
+
+	void RecordSizer::sent(size_t bytes, uint32_t now) noexcept
+	{
+		update_window(now);
+		_window_bytes += bytes;
+	}
+
+
+	void RecordSizer::update_window(uint32_t now) noexcept
+	{
+		const uint32_t elapsed = now - _window_start;
+
+		if (elapsed >= RATE_WINDOW) {
+			// The previous window is forgotten if nothing was sent during a window.
+			_previous_bytes = elapsed < 2 * RATE_WINDOW ? _window_bytes : 0;
+			_window_bytes = 0;
+			_window_start = now;
+		}
+	}
+
+}
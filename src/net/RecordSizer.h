@@ -0,0 +1,65 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace net {
+
+	/**
+	* RecordSizer: selects the size of the TLS records sent in the tunnel.
+	*
+	* Interactive traffic is sent with one record per PPP frame, a record is not
+	* larger than a TCP segment and can be decrypted by the firewall as soon as
+	* the segment arrives.
+	* When the rate of the tunnel exceeds a threshold during the current or the
+	* previous measurement window, the PPP frames are coalesced in full 16 KB
+	* records to reduce the per record cost (AEAD setup, header and tag, send
+	* call).
+	*
+	* The time is given by the lwIP clock (ms).
+	*/
+	class RecordSizer final
+	{
+	public:
+		/**
+		 * Creates a record sizer.
+		 *
+		 * @param enabled If false, each PPP frame is sent in its own record.
+		*/
+		explicit RecordSizer(bool enabled) noexcept;
+
+		/**
+		 * Returns the maximum size of the next record, 0 if the frames
+		 * must not be coalesced (interactive traffic or sizing disabled).
+		*/
+		size_t record_size(uint32_t now) noexcept;
+
+		/**
+		 * Accounts the bytes sent in the tunnel.
+		*/
+		void sent(size_t bytes, uint32_t now) noexcept;
+
+	private:
+		// True if the records are sized by this object.
+		const bool _enabled;
+
+		// Bytes sent during the current and the previous window.
+		size_t _window_bytes;
+		size_t _previous_bytes;
+
+		// Time of the start of the current window.
+		uint32_t _window_start;
+
+		// Starts a new window if the current one is elapsed.
+		void update_window(uint32_t now) noexcept;
+	};
+
+}
@@ -7,9 +7,13 @@
 */
 #include <winsock2.h>
 #include <Ws2ipdef.h>
+#include <ws2tcpip.h>
+#include <mstcpip.h>
 #include "Socket.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <vector>
 
 
 namespace net {
@@ -33,9 +37,40 @@ namespace net {
 	}
 
 
+	// Delay between two connection attempts (see RFC 8305 section 5).
+	static constexpr uint32_t CONNECTION_ATTEMPT_DELAY = 250;
+
+
+	// Sorts the resolved addresses by interleaving the address families as
+	// recommended by RFC 8305 section 4.  The family of the first address
+	// returned by the resolver is tried first.
+	static std::vector<const addrinfo*> sort_addresses(const addrinfo* addr_list)
+	{
+		std::vector<const addrinfo*> first_family;
+		std::vector<const addrinfo*> other_family;
+
+		for (const addrinfo* cur = addr_list; cur; cur = cur->ai_next) {
+			if (cur->ai_family == addr_list->ai_family)
+				first_family.push_back(cur);
+			else
+				other_family.push_back(cur);
+		}
+
+		std::vector<const addrinfo*> addresses;
+		for (size_t i = 0; i < std::max(first_family.size(), other_family.size()); i++) {
+			if (i < first_family.size())
+				addresses.push_back(first_family[i]);
+			if (i < other_family.size())
+				addresses.push_back(other_family[i]);
+		}
+
+		return addresses;
+	}
+
+
 	utl::mbed_err Socket::connect(const net::Endpoint& ep, net::net_protocol protocol, const utl::Timer& timer)
 	{
-		LWIP_UNUSED_ARG(timer);
+		DEBUG_ENTER_FMT(_logger, "ep=%s", ep.to_string().c_str());
 
 		if (get_fd() != -1) {
 			// The socket is connected.
@@ -44,11 +79,136 @@ namespace net {
 
 		const std::string host{ ep.hostname() };
 		const std::string port{ std::to_string(ep.port()) };
-		const int mbedtls_proto = (protocol == net_protocol::NETCTX_PROTO_TCP)
-			? MBEDTLS_NET_PROTO_TCP
-			: MBEDTLS_NET_PROTO_UDP;
 
-		return ::mbedtls_net_connect(&_netctx, host.c_str(),port.c_str(), mbedtls_proto);
+		if (protocol == net_protocol::NETCTX_PROTO_UDP) {
+			// There is no handshake to race for a datagram socket.
+			return ::mbedtls_net_connect(&_netctx, host.c_str(), port.c_str(), MBEDTLS_NET_PROTO_UDP);
+		}
+
+		addrinfo hints{};
+		hints.ai_family = AF_UNSPEC;
+		hints.ai_socktype = SOCK_STREAM;
+		hints.ai_protocol = IPPROTO_TCP;
+
+		addrinfo* addr_list = nullptr;
+		if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &addr_list) != 0 || !addr_list)
+			return MBEDTLS_ERR_NET_UNKNOWN_HOST;
+
+		// Race connections to all resolved addresses.  A new attempt is started 
+		// every CONNECTION_ATTEMPT_DELAY ms or as soon as the previous attempt 
+		// failed.  The first established connection wins, other attempts are
+		// cancelled.
+		const std::vector<const addrinfo*> addresses{ sort_addresses(addr_list) };
+		std::vector<SOCKET> attempts;
+		SOCKET winner = INVALID_SOCKET;
+		size_t next = 0;
+		utl::Timer attempt_timer{ 0 };
+
+		while (winner == INVALID_SOCKET && !timer.is_elapsed()) {
+			if (next < addresses.size() && (attempts.empty() || attempt_timer.is_elapsed())) {
+				// Start a new connection attempt.
+				const addrinfo* const addr = addresses[next++];
+				const SOCKET fd = ::socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
+				if (fd == INVALID_SOCKET)
+					continue;
+
+				u_long non_blocking = 1;
+				if (::ioctlsocket(fd, FIONBIO, &non_blocking) != 0) {
+					::closesocket(fd);
+					continue;
+				}
+
+				LOG_DEBUG(_logger, "connection attempt %zu/%zu to %s",
+					next, addresses.size(), ep.to_string().c_str());
+
+				if (::connect(fd, addr->ai_addr, static_cast<int>(addr->ai_addrlen)) == 0) {
+					winner = fd;
+				}
+				else if (::WSAGetLastError() == WSAEWOULDBLOCK) {
+					attempts.push_back(fd);
+					attempt_timer.start(CONNECTION_ATTEMPT_DELAY);
+				}
+				else {
+					::closesocket(fd);
+				}
+
+				continue;
+			}
+
+			if (attempts.empty()) {
+				// All attempts failed.
+				break;
+			}
+
+			// Wait until an attempt completes, the next attempt is due or the
+			// connection timer has elapsed.
+			fd_set write_set;
+			fd_set except_set;
+			FD_ZERO(&write_set);
+			FD_ZERO(&except_set);
+			for (const SOCKET fd : attempts) {
+				FD_SET(fd, &write_set);
+				FD_SET(fd, &except_set);
+			}
+
+			uint32_t wait_time = timer.remaining_time();
+			if (next < addresses.size())
+				wait_time = std::min(wait_time, attempt_timer.remaining_time());
+
+			timeval timeout;
+			timeout.tv_sec = wait_time / 1000;
+			timeout.tv_usec = (wait_time % 1000) * 1000;
+
+			if (::select(0, nullptr, &write_set, &except_set, &timeout) == SOCKET_ERROR) {
+				_logger->error("ERROR: %s 0x%012Ix - select error=%d",
+					__class__,
+					PTR_VAL(this),
+					::WSAGetLastError()
+				);
+				break;
+			}
+
+			for (auto it = attempts.begin(); it != attempts.end();) {
+				const SOCKET fd = *it;
+
+				if (FD_ISSET(fd, &except_set)) {
+					// The connection was refused or is unreachable.
+					::closesocket(fd);
+					it = attempts.erase(it);
+
+					// Do not wait before starting the next attempt.
+					attempt_timer.start(0);
+				}
+				else if (FD_ISSET(fd, &write_set) && winner == INVALID_SOCKET) {
+					winner = fd;
+					it = attempts.erase(it);
+				}
+				else {
+					++it;
+				}
+			}
+		}
+
+		// Cancel all pending attempts.
+		for (const SOCKET fd : attempts)
+			::closesocket(fd);
+
+		::freeaddrinfo(addr_list);
+
+		if (winner == INVALID_SOCKET) {
+			if (timer.is_elapsed())
+				_logger->error("ERROR: timeout, can't connect to %s", ep.to_string().c_str());
+
+			return MBEDTLS_ERR_NET_CONNECT_FAILED;
+		}
+
+		// Restore the blocking mode, as mbedtls_net_connect does.
+		u_long non_blocking = 0;
+		::ioctlsocket(winner, FIONBIO, &non_blocking);
+
+		_netctx.fd = static_cast<int>(winner);
+
+		return 0;
 	}
 
 
@@ -94,6 +254,15 @@ namespace net {
 	}
 
 
+	void Socket::take_over(Socket& other) noexcept
+	{
+		::mbedtls_net_close(&_netctx);
+
+		_netctx.fd = other._netctx.fd;
+		other._netctx.fd = -1;
+	}
+
+
 	utl::mbed_err Socket::shutdown()
 	{
 		// Gracefully shutdown the connection and close the socket.
@@ -141,6 +310,29 @@ namespace net {
 	}
 
 
+	utl::mbed_err Socket::get_nodelay(bool& no_delay) const
+	{
+		mbed_err rc = MBEDTLS_ERR_NET_INVALID_CONTEXT;
+
+		if (get_fd() != -1) {
+			int tcp_nodelay = 0;
+			int optlen = sizeof(tcp_nodelay);
+
+			if (::getsockopt(
+				get_fd(),
+				IPPROTO_TCP,
+				TCP_NODELAY,
+				reinterpret_cast<char*>(&tcp_nodelay),
+				&optlen) == 0) {
+				no_delay = tcp_nodelay != 0;
+				rc = 0;
+			}
+		}
+
+		return rc;
+	}
+
+
 	net::rcv_status Socket::recv_data(unsigned char* buf, size_t len)
 	{
 		rcv_status status { rcv_status_code::NETCTX_RCV_ERROR, MBEDTLS_ERR_NET_INVALID_CONTEXT, 0 };
@@ -221,6 +413,25 @@ namespace net {
 	}
 
 
+	bool Socket::get_rtt(uint32_t& rtt) const noexcept
+	{
+		if (get_fd() == -1)
+			return false;
+
+		DWORD version = 0;
+		TCP_INFO_v0 info;
+		DWORD bytes = 0;
+
+		const int rc = ::WSAIoctl(get_fd(), SIO_TCP_INFO, &version, sizeof(version), 
+			&info, sizeof(info), &bytes, nullptr, nullptr);
+		if (rc != 0 || bytes < sizeof(info))
+			return false;
+
+		rtt = info.RttUs / 1000;
+		return true;
+	}
+
+
 	net::Socket::poll_status Socket::poll(int rw, uint32_t timeout)
 	{
 		poll_status status { poll_status_code::NETCTX_POLL_ERROR, MBEDTLS_ERR_NET_INVALID_CONTEXT };
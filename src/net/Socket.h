@@ -124,6 +124,10 @@ namespace net {
 		 * the remaining time on the timer, the connection is canceled, and the function
 		 * returns a negative error code.
 		 *
+		 * For TCP, all addresses resolved from the endpoint host name are raced
+		 * using staggered attempts (RFC 8305). The first established connection
+		 * is kept and the other attempts are cancelled.
+		 *
 		 * @param ep The endpoint to connect to.
 		 * @param protocol Specify the IP protocol (TCP or UPD).
 		 * @param timer A timer specifying the timeout duration for the connection. If the
@@ -188,6 +192,16 @@ namespace net {
 		 */
 		utl::mbed_err set_nodelay(bool no_delay);
 
+		/**
+		 * Returns the no-delay option of the socket.
+		 *
+		 * @param no_delay Set to `true` if the Nagle algorithm is disabled.
+		 *
+		 * @return An error code of type `mbed_err` indicating the success or failure
+		 *         of reading the option.
+		 */
+		utl::mbed_err get_nodelay(bool& no_delay) const;
+
 		/**
 		 * Receives data from the socket.
 		 *
@@ -235,6 +249,16 @@ namespace net {
 		 */
 		bool get_port(uint16_t& port) const noexcept;
 
+		/**
+		 * Retrieves the smoothed round trip time measured by the TCP stack.
+		 *
+		 * @param rtt The round trip time in ms.
+		 *
+		 * @return False if the socket is not connected or if the information
+		 *         is not available (requires Windows 10 1703 or later).
+		 */
+		bool get_rtt(uint32_t& rtt) const noexcept;
+
 	protected:
 		// A reference to the application logger.
 		utl::Logger* const _logger;
@@ -247,6 +271,11 @@ namespace net {
 		*/
 		inline mbedtls_net_context* netctx()  noexcept { return &_netctx; }
 
+		/* Closes this socket and takes over the connection of another socket.
+		 * The other socket is left disconnected.
+		*/
+		void take_over(Socket& other) noexcept;
+
 		/**
 		 * @enum poll_status_code
 		 * Enumerates the possible status codes for a polling operation.
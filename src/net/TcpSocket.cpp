@@ -45,7 +45,19 @@ namespace net {
 
 	net::rcv_status TcpSocket::read(unsigned char* buf, size_t len, const utl::Timer& timer)
 	{
-		TRACE_ENTER_FMT(_logger, "buffer=0x%012Ix size=%zu", PTR_VAL(buf), len);
+		return receive(buf, len, true, timer);
+	}
+
+
+	net::rcv_status TcpSocket::read_some(unsigned char* buf, size_t len, const utl::Timer& timer)
+	{
+		return receive(buf, len, false, timer);
+	}
+
+
+	net::rcv_status TcpSocket::receive(unsigned char* buf, size_t len, bool fill, const utl::Timer& timer)
+	{
+		TRACE_ENTER_FMT(_logger, "buffer=0x%012Ix size=%zu fill=%d", PTR_VAL(buf), len, fill);
 
 		rcv_status read_status { rcv_status_code::NETCTX_RCV_OK, 0, 0 };
 
@@ -62,7 +74,7 @@ namespace net {
 				len -= rcv_data_status.rbytes;
 				read_status.rbytes += rcv_data_status.rbytes;
 
-				keep_reading = len > 0;
+				keep_reading = fill && len > 0;
 			}
 			else if (read_status.code == rcv_status_code::NETCTX_RCV_RETRY) {
 				// Handle the "Busy/Retry" case
@@ -51,6 +51,21 @@ namespace net {
 		 */
 		virtual net::rcv_status read(unsigned char* buf, size_t len, const utl::Timer& timer);
 
+		/**
+		 * Reads the bytes available from the socket.
+		 *
+		 * The function waits until at least one byte is received or the specified
+		 * `timer` elapses, it then returns the bytes received, up to `len` bytes.
+		 *
+		 * @param buf Pointer to the buffer where received data will be stored.
+		 * @param len The maximum number of bytes to read.
+		 * @param timer The maximum amount of time to wait for the first byte.
+		 *
+		 * @return A value of type `rcv_status` indicating the status of the
+		 *         read operation.
+		 */
+		net::rcv_status read_some(unsigned char* buf, size_t len, const utl::Timer& timer);
+
 		/**
 		 * Writes a sequence of bytes to the socket.
 		 *
@@ -89,6 +104,10 @@ namespace net {
 	private:
 		// The class name.
 		static const char* __class__;
+
+		// Reads until `len` bytes are received if `fill` is true, or until
+		// at least one byte is received.
+		net::rcv_status receive(unsigned char* buf, size_t len, bool fill, const utl::Timer& timer);
 	};
 
 }
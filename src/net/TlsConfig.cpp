@@ -6,6 +6,8 @@
 *
 */
 #include "TlsConfig.h"
+#include <algorithm>
+#include <iterator>
 #include <mbedtls/debug.h>
 
 
@@ -73,8 +75,23 @@ namespace net {
 	};
 
 
-	TlsConfig::TlsConfig() :
-		_logger(Logger::get_logger())
+	// Cipher suites that differ only by the AEAD cipher.
+	static const int aead_pairs[][2] = {
+		{ MBEDTLS_TLS1_3_AES_128_GCM_SHA256, MBEDTLS_TLS1_3_CHACHA20_POLY1305_SHA256 },
+		{ MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256, MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256 }
+	};
+
+
+	// DTLS handshake retransmission timeouts (in ms).  The maximum is kept low,
+	// the stream transport is used if the firewall does not answer.
+	static constexpr uint32_t DTLS_TIMEOUT_MIN = 500;
+	static constexpr uint32_t DTLS_TIMEOUT_MAX = 4000;
+
+
+	TlsConfig::TlsConfig(net_protocol protocol) :
+		_logger(Logger::get_logger()),
+		_protocol(protocol),
+		_ciphers(std::begin(default_ciphers), std::end(default_ciphers))
 	{
 		DEBUG_CTOR(_logger);
 		::mbedtls_entropy_init(&_entropy_ctx);
@@ -82,17 +99,15 @@ namespace net {
 		::mbedtls_ctr_drbg_init(&_ctr_drbg);
 		::mbedtls_ctr_drbg_seed(&_ctr_drbg, mbedtls_entropy_func, &_entropy_ctx, nullptr, 0);
 
-		::mbedtls_ssl_config_init(&_ssl_config);
-		::mbedtls_ssl_config_defaults(&_ssl_config, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
-		::mbedtls_ssl_conf_authmode(&_ssl_config, MBEDTLS_SSL_VERIFY_REQUIRED);
-		::mbedtls_ssl_conf_rng(&_ssl_config, mbedtls_ctr_drbg_random, &_ctr_drbg);
+		// set cipher list, AES-GCM is preferred if the processor accelerates it.
+		order_ciphers(AeadSelector::detect());
 
-		// 1.2 and 1.3 are accepted
-		::mbedtls_ssl_conf_min_tls_version(&_ssl_config, MBEDTLS_SSL_VERSION_TLS1_2);
+		init_config(_ssl_config, MBEDTLS_SSL_VERIFY_REQUIRED);
+
+		// The chain of a certificate already trusted by the caller is not
+		// verified, the caller compares the certificate after the handshake.
+		init_config(_unverified_config, MBEDTLS_SSL_VERIFY_NONE);
 
-		// set cipher list
-		::mbedtls_ssl_conf_ciphersuites(&_ssl_config, default_ciphers);
-		
 #if defined _DEBUG
 		// verify if the ciphers are available.  The MbedTLS configuration is
 		// complex and it could be possible to define ciphers that are not
@@ -104,8 +119,6 @@ namespace net {
 #endif
 
 		if (_logger->is_trace_enabled()) {
-			// define a debug callback
-			::mbedtls_ssl_conf_dbg(&_ssl_config, mbedtls_debug_fn, _logger);
 #ifndef _DEBUG
 			::mbedtls_debug_set_threshold(0);
 #else
@@ -119,18 +132,20 @@ namespace net {
 		DEBUG_DTOR(_logger);
 
 		// free all memory allocated by SSL library
+		::mbedtls_ssl_config_free(&_unverified_config);
 		::mbedtls_ssl_config_free(&_ssl_config);
 		::mbedtls_ctr_drbg_free(&_ctr_drbg);
 		::mbedtls_entropy_free(&_entropy_ctx);
 	}
 
     
-	void TlsConfig::set_ca_crt(mbedtls_x509_crt& ca_crt)
+	void TlsConfig::set_ca_store(utl::CaStore& ca_store)
 	{
 		DEBUG_ENTER(_logger);
 
-		::mbedtls_ssl_conf_ca_chain(&_ssl_config, &ca_crt, nullptr);
+		::mbedtls_ssl_conf_ca_cb(&_ssl_config, utl::CaStore::ca_cb, &ca_store);
 		::mbedtls_ssl_conf_authmode(&_ssl_config, MBEDTLS_SSL_VERIFY_OPTIONAL);
+		::mbedtls_ssl_conf_ca_cb(&_unverified_config, utl::CaStore::ca_cb, &ca_store);
 	}
 
 
@@ -138,13 +153,85 @@ namespace net {
 	{
 		DEBUG_ENTER(_logger);
 
-		return ::mbedtls_ssl_conf_own_cert(&_ssl_config, &own_crt, &own_key);
+		mbed_err rc = ::mbedtls_ssl_conf_own_cert(&_ssl_config, &own_crt, &own_key);
+		if (rc == 0)
+			rc = ::mbedtls_ssl_conf_own_cert(&_unverified_config, &own_crt, &own_key);
+
+		return rc;
+	}
+
+
+	void TlsConfig::set_aead_preference(bool benchmark)
+	{
+		DEBUG_ENTER_FMT(_logger, "benchmark=%d", benchmark);
+
+		const aead_cipher preferred = benchmark ? AeadSelector::benchmark() : AeadSelector::detect();
+		_logger->debug(">> preferred cipher %s", AeadSelector::name(preferred));
+
+		order_ciphers(preferred);
+	}
+
+
+	void TlsConfig::init_config(mbedtls_ssl_config& config, int authmode)
+	{
+		::mbedtls_ssl_config_init(&config);
+		::mbedtls_ssl_config_defaults(&config, MBEDTLS_SSL_IS_CLIENT,
+			is_datagram() ? MBEDTLS_SSL_TRANSPORT_DATAGRAM : MBEDTLS_SSL_TRANSPORT_STREAM,
+			MBEDTLS_SSL_PRESET_DEFAULT);
+		::mbedtls_ssl_conf_authmode(&config, authmode);
+		::mbedtls_ssl_conf_rng(&config, mbedtls_ctr_drbg_random, &_ctr_drbg);
+
+		// 1.2 and 1.3 are accepted
+		::mbedtls_ssl_conf_min_tls_version(&config, MBEDTLS_SSL_VERSION_TLS1_2);
+
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+		if (is_datagram()) {
+			// DTLS 1.3 is not implemented by mbedtls.
+			::mbedtls_ssl_conf_max_tls_version(&config, MBEDTLS_SSL_VERSION_TLS1_2);
+			::mbedtls_ssl_conf_handshake_timeout(&config, DTLS_TIMEOUT_MIN, DTLS_TIMEOUT_MAX);
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+			// The client does not need a connection ID, it accepts the one the
+			// firewall provides to keep the association when the address changes.
+			::mbedtls_ssl_conf_cid(&config, 0, MBEDTLS_SSL_UNEXPECTED_CID_IGNORE);
+#endif
+		}
+#endif
+
+		// Both configurations share the cipher list.
+		::mbedtls_ssl_conf_ciphersuites(&config, _ciphers.data());
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS) && defined(MBEDTLS_SSL_PROTO_TLS1_3)
+		// TLS 1.3 tickets are ignored by default, they are needed to resume a session.
+		::mbedtls_ssl_conf_tls13_enable_signal_new_session_tickets(&config,
+			MBEDTLS_SSL_TLS1_3_SIGNAL_NEW_SESSION_TICKETS_ENABLED);
+#endif
+
+		if (_logger->is_trace_enabled()) {
+			// define a debug callback
+			::mbedtls_ssl_conf_dbg(&config, mbedtls_debug_fn, _logger);
+		}
+	}
+
+
+	void TlsConfig::order_ciphers(aead_cipher preferred)
+	{
+		const size_t first = preferred == aead_cipher::AES_GCM ? 0 : 1;
+
+		// The suites are reordered in place, mbedtls keeps a pointer to the list.
+		for (const auto& pair : aead_pairs) {
+			const auto it1 = std::find(_ciphers.begin(), _ciphers.end(), pair[first]);
+			const auto it2 = std::find(_ciphers.begin(), _ciphers.end(), pair[1 - first]);
+
+			if (it1 != _ciphers.end() && it2 != _ciphers.end() && it2 < it1)
+				std::iter_swap(it1, it2);
+		}
 	}
 
 
-	const mbedtls_ssl_config* TlsConfig::get_cfg() const
+	const mbedtls_ssl_config* TlsConfig::get_cfg(bool verify_crt) const
 	{
-		return &_ssl_config;
+		return verify_crt ? &_ssl_config : &_unverified_config;
 	}
 
 
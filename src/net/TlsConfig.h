@@ -11,7 +11,11 @@
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/entropy.h>
 #include <mbedtls/x509_crt.h>
+#include <vector>
 
+#include "net/AeadSelector.h"
+#include "net/Socket.h"
+#include "util/CaStore.h"
 #include "util/Logger.h"
 #include "util/ErrUtil.h"
 
@@ -20,14 +24,21 @@ namespace net {
 
 	class TlsConfig {
 	public:
-		explicit TlsConfig();
+		/**
+		 * Creates a TLS configuration.
+		 *
+		 * @param protocol NETCTX_PROTO_TCP for a TLS stream, NETCTX_PROTO_UDP
+		 *                 for a DTLS 1.2 transport.
+		*/
+		explicit TlsConfig(net_protocol protocol = net_protocol::NETCTX_PROTO_TCP);
 		TlsConfig(const TlsConfig& config) = delete;
 		~TlsConfig();
 
 		/**
-		 * Defines the CA certificates.
+		 * Defines the store of the CA certificates, the certificates are
+		 * looked up by the store during the verification.
 		*/
-		void set_ca_crt(mbedtls_x509_crt& ca_crt);
+		void set_ca_store(utl::CaStore& ca_store);
 
 		/**
 		 * Defines the client certificate.
@@ -35,9 +46,29 @@ namespace net {
 		utl::mbed_err set_user_crt(mbedtls_x509_crt& own_crt, mbedtls_pk_context& own_key);
 
 		/**
+		 * Offers first the AEAD cipher that performs the best on this computer.
+		 *
+		 * By default, the order is selected from the processor capabilities.
+		 * When `benchmark` is true, the throughput of each cipher is measured
+		 * once and the fastest cipher is preferred.  The function must be
+		 * called before a socket is connected.
+		*/
+		void set_aead_preference(bool benchmark);
+
+		/**
+		 * Returns the mbedtls_ssl_config.
+		 *
+		 * @param verify_crt If `false`, the returned configuration does not
+		 *                   verify the server certificate chain.  The caller
+		 *                   must compare the certificate after the handshake.
 		 * @return the mbedtls_ssl_config.
 		*/
-		const mbedtls_ssl_config* get_cfg() const;
+		const mbedtls_ssl_config* get_cfg(bool verify_crt = true) const;
+
+		/**
+		 * Returns true if this configuration applies to a datagram transport.
+		*/
+		inline bool is_datagram() const noexcept { return _protocol == net_protocol::NETCTX_PROTO_UDP; }
 
 	private:
 		// The class name
@@ -46,9 +77,22 @@ namespace net {
 		// A reference to the application logger.
 		utl::Logger* const _logger;
 
+		// The transport protocol.
+		const net_protocol _protocol;
+
 		// All data required to initialize a TLS socket.
 		mbedtls_entropy_context _entropy_ctx;
 		mbedtls_ctr_drbg_context _ctr_drbg;
 		mbedtls_ssl_config _ssl_config;
+		mbedtls_ssl_config _unverified_config;
+
+		// The cipher suites offered to the server, the list is terminated by 0.
+		std::vector<int> _ciphers;
+
+		// Initializes a client configuration with the given verification mode.
+		void init_config(mbedtls_ssl_config& config, int authmode);
+
+		// Orders the cipher suites according to the preferred AEAD cipher.
+		void order_ciphers(aead_cipher preferred);
 	};
 }
\ No newline at end of file
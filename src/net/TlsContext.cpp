@@ -10,9 +10,10 @@
 namespace net {
 
 	TlsContext::TlsContext() :
-		_sslctx{}
+		_sslctx(std::make_unique<mbedtls_ssl_context>()),
+		_timer{}
 	{
-		::mbedtls_ssl_init(&_sslctx);
+		::mbedtls_ssl_init(_sslctx.get());
 	}
 
 
@@ -24,21 +25,63 @@ namespace net {
 
 	utl::mbed_err TlsContext::configure(const mbedtls_ssl_config& config, mbedtls_net_context& netctx)
 	{
-		::mbedtls_ssl_set_bio(&_sslctx, &netctx, mbedtls_net_send, mbedtls_net_recv, nullptr);
+		::mbedtls_ssl_set_bio(_sslctx.get(), &netctx, mbedtls_net_send, mbedtls_net_recv, nullptr);
 
-		return ::mbedtls_ssl_setup(&_sslctx, &config);
+		return ::mbedtls_ssl_setup(_sslctx.get(), &config);
 	}
 
 
 	void TlsContext::clear()
 	{
-		::mbedtls_ssl_free(&_sslctx);
+		::mbedtls_ssl_free(_sslctx.get());
+	}
+
+
+	utl::mbed_err TlsContext::configure_datagram(uint16_t mtu)
+	{
+		utl::mbed_err rc = 0;
+
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+		::mbedtls_ssl_set_timer_cb(_sslctx.get(), &_timer, mbedtls_timing_set_delay, mbedtls_timing_get_delay);
+		::mbedtls_ssl_set_mtu(_sslctx.get(), mtu);
+
+#if defined(MBEDTLS_SSL_DTLS_CONNECTION_ID)
+		rc = ::mbedtls_ssl_set_cid(_sslctx.get(), MBEDTLS_SSL_CID_ENABLED, nullptr, 0);
+#endif
+#else
+		rc = MBEDTLS_ERR_SSL_FEATURE_UNAVAILABLE;
+#endif
+
+		return rc;
+	}
+
+
+	void TlsContext::take_over(TlsContext& other, mbedtls_net_context& netctx)
+	{
+		clear();
+
+		// The SSL context is allocated on the heap, the ownership is exchanged
+		// and the other context receives the released context.
+		std::swap(_sslctx, other._sslctx);
+		::mbedtls_ssl_set_bio(_sslctx.get(), &netctx, mbedtls_net_send, mbedtls_net_recv, nullptr);
 	}
 
 
 	utl::mbed_err TlsContext::set_hostname(const std::string& hostname)
 	{
-		return ::mbedtls_ssl_set_hostname(&_sslctx, hostname.c_str());
+		return ::mbedtls_ssl_set_hostname(_sslctx.get(), hostname.c_str());
+	}
+
+
+	bool TlsContext::restore_session(TlsSession& session, const std::string& hostname)
+	{
+		return session.restore(*_sslctx, hostname);
+	}
+
+
+	utl::mbed_err TlsContext::save_session(TlsSession& session, const std::string& hostname) const
+	{
+		return session.save(*_sslctx, hostname);
 	}
 
 
@@ -46,7 +89,7 @@ namespace net {
 	{
 		tls_close_status status { close_status_code::SSLCTX_CLOSE_ERROR, MBEDTLS_ERR_SSL_BAD_INPUT_DATA };
 
-		const int rc = ::mbedtls_ssl_close_notify(&_sslctx);
+		const int rc = ::mbedtls_ssl_close_notify(_sslctx.get());
 		if (rc == 0) {
 			status.status_code = close_status_code::SSLCTX_CLOSE_OK;
 			status.rc = 0;
@@ -71,7 +114,7 @@ namespace net {
 	{
 		tls_handshake_status status { hdk_status_code::SSLCTX_HDK_ERROR, MBEDTLS_ERR_SSL_BAD_INPUT_DATA };
 
-		status.rc = ::mbedtls_ssl_handshake(&_sslctx);
+		status.rc = ::mbedtls_ssl_handshake(_sslctx.get());
 		switch (status.rc) {
 		case 0:
 			status.status_code = hdk_status_code::SSLCTX_HDK_OK;
@@ -105,7 +148,7 @@ namespace net {
 	{
 		rcv_status status { rcv_status_code::NETCTX_RCV_ERROR, MBEDTLS_ERR_SSL_BAD_INPUT_DATA, 0 };
 
-		const int rc = ::mbedtls_ssl_read(&_sslctx, buf, len);
+		const int rc = ::mbedtls_ssl_read(_sslctx.get(), buf, len);
 
 		if (rc > 0) {
 			status.code = rcv_status_code::NETCTX_RCV_OK;
@@ -137,7 +180,7 @@ namespace net {
 	{
 		snd_status status{ snd_status_code::NETCTX_SND_ERROR, MBEDTLS_ERR_SSL_BAD_INPUT_DATA, 0 };
 
-		const int rc = ::mbedtls_ssl_write(&_sslctx, buf, len);
+		const int rc = ::mbedtls_ssl_write(_sslctx.get(), buf, len);
 
 		if (rc > 0) {
 			status.code = snd_status_code::NETCTX_SND_OK;
@@ -163,25 +206,31 @@ namespace net {
 
 	utl::mbed_err TlsContext::get_crt_check() const
 	{
-		return ::mbedtls_ssl_get_verify_result(&_sslctx);
+		return ::mbedtls_ssl_get_verify_result(_sslctx.get());
 	}
 
 
 	std::string TlsContext::get_ciphersuite() const
 	{
-		return ::mbedtls_ssl_get_ciphersuite(&_sslctx);
+		return ::mbedtls_ssl_get_ciphersuite(_sslctx.get());
 	}
 
 
 	std::string TlsContext::get_tls_version() const
 	{
-		return ::mbedtls_ssl_get_version(&_sslctx);
+		return ::mbedtls_ssl_get_version(_sslctx.get());
+	}
+
+
+	mbedtls_ssl_protocol_version TlsContext::get_tls_version_number() const
+	{
+		return ::mbedtls_ssl_get_version_number(_sslctx.get());
 	}
 
 
 	const mbedtls_x509_crt* TlsContext::get_peer_crt() const
 	{
-		return ::mbedtls_ssl_get_peer_cert(&_sslctx);
+		return ::mbedtls_ssl_get_peer_cert(_sslctx.get());
 	}
 
 }
@@ -7,11 +7,14 @@
 */
 #pragma once
 
+#include <memory>
 #include <string>
 #include <mbedtls/net_sockets.h>
 #include <mbedtls/ssl.h>
+#include <mbedtls/timing.h>
 
 #include "net/Socket.h"
+#include "net/TlsSession.h"
 #include "util/ErrUtil.h"
 
 
@@ -122,12 +125,49 @@ namespace net {
 		 */
 		void clear();
 
+		/**
+		 * Configures the datagram specific parameters of a DTLS context.  The
+		 * function must be called after `configure`.
+		 *
+		 * The retransmission timer of the handshake is installed, the handshake
+		 * messages are fragmented to fit in the specified MTU and the connection
+		 * ID extension is offered to the server.
+		 *
+		 * @param mtu The maximum size of a datagram.
+		 */
+		utl::mbed_err configure_datagram(uint16_t mtu);
+
+		/**
+		 * Takes over the established TLS connection of another context.
+		 *
+		 * The SSL context of this object is released and replaced by the context
+		 * of `other`, the other context is left cleared.  The connection is now
+		 * read from and written to the specified network context.
+		 *
+		 * @param other  The context that currently holds the connection.
+		 * @param netctx The network context that now holds the connection.
+		 */
+		void take_over(TlsContext& other, mbedtls_net_context& netctx);
+
 		/**
 		 *  Sets host name to check against the received server certificate.
 		 * 
 		 */
 		utl::mbed_err set_hostname(const std::string& hostname);
 
+		/**
+		 * Offers a saved session to the server.  The function must be called
+		 * before the handshake.
+		 *
+		 * @return true if a session saved for this host is offered.
+		*/
+		bool restore_session(TlsSession& session, const std::string& hostname);
+
+		/**
+		 * Saves the current session so that a future connection can resume it.
+		*/
+		utl::mbed_err save_session(TlsSession& session, const std::string& hostname) const;
+
 		/**
 		 * Notifies the peer that the connection is being closed.
 		 *
@@ -184,6 +224,11 @@ namespace net {
 		*/
 		std::string get_tls_version() const;
 
+		/**
+		 * Returns the TLS version number.
+		*/
+		mbedtls_ssl_protocol_version get_tls_version_number() const;
+
 		/**
 		 * Returns a pointer to the X509 certificate received from the TLS server.
 		 *
@@ -193,7 +238,12 @@ namespace net {
 		const mbedtls_x509_crt* get_peer_crt() const;
 
 	private:
-		mbedtls_ssl_context _sslctx;
+		// The SSL context, allocated on the heap so that it can be transferred
+		// to another context.
+		std::unique_ptr<mbedtls_ssl_context> _sslctx;
+
+		// The retransmission timer of a DTLS context.
+		mbedtls_timing_delay_context _timer;
 	};
 
 }
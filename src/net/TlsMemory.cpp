@@ -0,0 +1,161 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "TlsMemory.h"
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <mbedtls/platform.h>
+#include "util/Mutex.h"
+
+
+namespace net {
+	using namespace utl;
+
+	// The size classes of the pools and the maximum number of free blocks
+	// kept by each pool.  The last class holds the record buffers, their size
+	// is 16 KB plus the record header and the expansion of the cipher.
+	static constexpr size_t POOL_COUNT = 8;
+	static constexpr std::array<size_t, POOL_COUNT> POOL_SIZES{ 64, 128, 256, 512, 1024, 2048, 4096, 20 * 1024 };
+	static constexpr std::array<size_t, POOL_COUNT> POOL_LIMITS{ 256, 256, 128, 64, 32, 32, 16, 8 };
+	static constexpr size_t RECORD_POOL = POOL_COUNT - 1;
+	static constexpr size_t MIN_RECORD_SIZE = 16 * 1024;
+	static constexpr size_t NO_POOL = POOL_COUNT;
+
+	// Each block starts with a header, the size of the header preserves the
+	// alignment of the heap blocks.
+	struct alignas(16) block_header {
+		size_t size;				// requested size
+		size_t pool;				// index of the pool or NO_POOL
+	};
+
+	// A free block is linked to the next free block of the same pool.
+	struct free_block {
+		free_block* next;
+	};
+
+	struct memory_state {
+		Mutex mutex;
+		std::array<free_block*, POOL_COUNT> pools{};
+		std::array<size_t, POOL_COUNT> counts{};
+		tls_memory_stats stats{};
+	};
+
+
+	static memory_state& state()
+	{
+		// The state is never released, mbedtls objects may be freed
+		// during the destruction of static objects.
+		static memory_state* const instance = new memory_state();
+		return *instance;
+	}
+
+
+	static size_t pool_index(size_t size) noexcept
+	{
+		if (size > MIN_RECORD_SIZE)
+			return size <= POOL_SIZES[RECORD_POOL] ? RECORD_POOL : NO_POOL;
+
+		for (size_t i = 0; i < RECORD_POOL; i++) {
+			if (size <= POOL_SIZES[i])
+				return i;
+		}
+
+		return NO_POOL;
+	}
+
+
+	void TlsMemory::install()
+	{
+		state();
+		::mbedtls_platform_set_calloc_free(TlsMemory::calloc, TlsMemory::free);
+	}
+
+
+	tls_memory_stats TlsMemory::get_stats()
+	{
+		memory_state& memory = state();
+		Mutex::Lock lock{ memory.mutex };
+
+		return memory.stats;
+	}
+
+
+	void* TlsMemory::calloc(size_t count, size_t size)
+	{
+		if (size > 0 && count > (SIZE_MAX - sizeof(block_header)) / size)
+			return nullptr;
+
+		// A zero size allocation returns a unique pointer.
+		const size_t len = count * size > 0 ? count * size : 1;
+		const size_t pool = pool_index(len);
+		memory_state& memory = state();
+		block_header* header = nullptr;
+
+		{
+			Mutex::Lock lock{ memory.mutex };
+
+			if (pool != NO_POOL && memory.pools[pool]) {
+				free_block* const block = memory.pools[pool];
+				memory.pools[pool] = block->next;
+				memory.counts[pool]--;
+				memory.stats.pool_hits++;
+
+				header = reinterpret_cast<block_header*>(block);
+			}
+		}
+
+		if (!header) {
+			const size_t block_size = pool != NO_POOL ? POOL_SIZES[pool] : len;
+			header = static_cast<block_header*>(std::malloc(sizeof(block_header) + block_size));
+			if (!header)
+				return nullptr;
+		}
+
+		header->size = len;
+		header->pool = pool;
+		void* const ptr = header + 1;
+		std::memset(ptr, 0, len);
+
+		Mutex::Lock lock{ memory.mutex };
+		memory.stats.allocations++;
+		memory.stats.in_use += len;
+		if (memory.stats.in_use > memory.stats.peak)
+			memory.stats.peak = memory.stats.in_use;
+
+		return ptr;
+	}
+
+
+	void TlsMemory::free(void* ptr)
+	{
+		if (!ptr)
+			return;
+
+		block_header* const header = static_cast<block_header*>(ptr) - 1;
+		const size_t pool = header->pool;
+		memory_state& memory = state();
+
+		{
+			Mutex::Lock lock{ memory.mutex };
+			memory.stats.in_use -= header->size;
+
+			if (pool != NO_POOL && memory.counts[pool] < POOL_LIMITS[pool]) {
+				free_block* const block = reinterpret_cast<free_block*>(header);
+				block->next = memory.pools[pool];
+				memory.pools[pool] = block;
+				memory.counts[pool]++;
+
+				return;
+			}
+		}
+
+		std::free(header);
+	}
+
+}
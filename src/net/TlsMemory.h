@@ -0,0 +1,55 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace net {
+
+	struct tls_memory_stats {
+		uint64_t allocations;		// number of allocations
+		uint64_t pool_hits;			// allocations served by a pool
+		size_t in_use;				// bytes currently allocated
+		size_t peak;				// maximum of in_use
+	};
+
+
+	/**
+	* TlsMemory: the allocator used by mbedtls.
+	*
+	* A handshake allocates hundreds of small blocks (parsed certificates,
+	* bignums, handshake messages) and each TLS context allocates two record
+	* buffers of about 16 KB.  The allocator keeps the released blocks in
+	* pools of fixed size classes, the next handshakes reuse them instead
+	* of fragmenting the process heap.  The other sizes are allocated from
+	* the heap.
+	*
+	* The pools are shared by all threads, the access is serialized.
+	*/
+	class TlsMemory final
+	{
+	public:
+		/**
+		 * Installs the allocator, the function must be called before any
+		 * mbedtls object is created.
+		*/
+		static void install();
+
+		/**
+		 * Returns the allocation statistics.
+		*/
+		static tls_memory_stats get_stats();
+
+	private:
+		static void* calloc(size_t count, size_t size);
+		static void free(void* ptr);
+	};
+
+}
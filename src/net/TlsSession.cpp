@@ -0,0 +1,146 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "TlsSession.h"
+
+#include "util/Logger.h"
+
+
+namespace net {
+	using namespace utl;
+
+
+	TlsSession::TlsSession() :
+		_session{},
+		_hostname(),
+		_version(MBEDTLS_SSL_VERSION_UNKNOWN),
+		_valid(false),
+		_mutex()
+	{
+		::mbedtls_ssl_session_init(&_session);
+	}
+
+
+	TlsSession::~TlsSession()
+	{
+		::mbedtls_ssl_session_free(&_session);
+	}
+
+
+	utl::mbed_err TlsSession::save(const mbedtls_ssl_context& sslctx, const std::string& hostname)
+	{
+		Mutex::Lock lock{ _mutex };
+
+		// The session must be empty before an export.
+		reset();
+
+		const mbed_err rc = ::mbedtls_ssl_get_session(&sslctx, &_session);
+		if (rc == 0) {
+			_hostname = hostname;
+			_version = ::mbedtls_ssl_get_version_number(&sslctx);
+			_valid = true;
+		}
+		else {
+			reset();
+		}
+
+		LOG_DEBUG(Logger::get_logger(), "host=%s rc=%d", hostname.c_str(), rc);
+
+		return rc;
+	}
+
+
+	bool TlsSession::restore(mbedtls_ssl_context& sslctx, const std::string& hostname)
+	{
+		Mutex::Lock lock{ _mutex };
+
+		if (!_valid || _hostname.compare(hostname) != 0)
+			return false;
+
+		const mbed_err rc = ::mbedtls_ssl_set_session(&sslctx, &_session);
+		LOG_DEBUG(Logger::get_logger(), "host=%s rc=%d", hostname.c_str(), rc);
+
+		// A TLS 1.3 ticket is not reused.
+		if (rc != 0 || _version == MBEDTLS_SSL_VERSION_TLS1_3)
+			reset();
+
+		return rc == 0;
+	}
+
+
+	void TlsSession::clear()
+	{
+		Mutex::Lock lock{ _mutex };
+
+		reset();
+	}
+
+
+	utl::mbed_err TlsSession::serialize(std::vector<unsigned char>& data, std::string& hostname,
+		mbedtls_ssl_protocol_version& version, uint32_t& lifetime)
+	{
+		Mutex::Lock lock{ _mutex };
+
+		if (!_valid)
+			return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+
+		// Get the size of the buffer.
+		size_t len = 0;
+		mbed_err rc = ::mbedtls_ssl_session_save(&_session, nullptr, 0, &len);
+		if (rc != MBEDTLS_ERR_SSL_BUFFER_TOO_SMALL)
+			return rc;
+
+		data.resize(len);
+		rc = ::mbedtls_ssl_session_save(&_session, data.data(), data.size(), &len);
+		if (rc)
+			return rc;
+
+		hostname = _hostname;
+		version = _version;
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+		lifetime = _session.MBEDTLS_PRIVATE(ticket_len) > 0 ? _session.MBEDTLS_PRIVATE(ticket_lifetime) : 0;
+#else
+		lifetime = 0;
+#endif
+
+		return 0;
+	}
+
+
+	utl::mbed_err TlsSession::deserialize(const std::vector<unsigned char>& data, const std::string& hostname,
+		mbedtls_ssl_protocol_version version)
+	{
+		Mutex::Lock lock{ _mutex };
+
+		reset();
+
+		const mbed_err rc = ::mbedtls_ssl_session_load(&_session, data.data(), data.size());
+		if (rc == 0) {
+			_hostname = hostname;
+			_version = version;
+			_valid = true;
+		}
+		else {
+			reset();
+		}
+
+		return rc;
+	}
+
+
+	void TlsSession::reset()
+	{
+		::mbedtls_ssl_session_free(&_session);
+		::mbedtls_ssl_session_init(&_session);
+		_hostname.clear();
+		_version = MBEDTLS_SSL_VERSION_UNKNOWN;
+		_valid = false;
+	}
+
+
+	const char* TlsSession::__class__ = "TlsSession";
+}
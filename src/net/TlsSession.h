@@ -0,0 +1,115 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <mbedtls/ssl.h>
+
+#include "util/ErrUtil.h"
+#include "util/Mutex.h"
+
+
+namespace net {
+
+	/**
+	* TlsSession: a TLS session that can be resumed by a future connection.
+	*
+	* The session is captured by a TLS socket once the handshake is complete
+	* (TLS 1.2) or when the server sends a session ticket (TLS 1.3).  It is
+	* offered by the next connections to the same host, the server can then
+	* skip the key exchange and the certificate verification.
+	*
+	* A TLS 1.3 ticket is offered only once as recommended by RFC 8446, the
+	* resumed connection receives a new ticket from the server.
+	*
+	* The session is shared by the portal client and the tunnel, the access
+	* is thus serialized.
+	*/
+	class TlsSession final
+	{
+	public:
+		TlsSession();
+		~TlsSession();
+
+		TlsSession(const TlsSession& session) = delete;
+		TlsSession& operator=(const TlsSession& session) = delete;
+
+		/**
+		 * Captures the session of a connection established with a host.
+		 *
+		 * @param sslctx   The SSL context of the connection.
+		 * @param hostname The name of the host.
+		 *
+		 * @return 0 if successful or an mbedtls error code.
+		*/
+		utl::mbed_err save(const mbedtls_ssl_context& sslctx, const std::string& hostname);
+
+		/**
+		 * Offers the saved session to a connection not yet started.
+		 *
+		 * Nothing is done if no session is saved for this host.
+		 *
+		 * @param sslctx   The SSL context of the connection.
+		 * @param hostname The name of the host.
+		 *
+		 * @return true if a session is offered.
+		*/
+		bool restore(mbedtls_ssl_context& sslctx, const std::string& hostname);
+
+		/**
+		 * Forgets the saved session.
+		*/
+		void clear();
+
+		/**
+		 * Serializes the saved session.
+		 *
+		 * @param data     The serialized session.
+		 * @param hostname The name of the host that issued the session.
+		 * @param version  The protocol version of the session.
+		 * @param lifetime The lifetime of the session ticket (s), 0 if the
+		 *                 server did not provide a ticket.
+		 *
+		 * @return 0 if successful or an mbedtls error code.
+		*/
+		utl::mbed_err serialize(std::vector<unsigned char>& data, std::string& hostname,
+			mbedtls_ssl_protocol_version& version, uint32_t& lifetime);
+
+		/**
+		 * Replaces the saved session by a serialized session.
+		 *
+		 * @return 0 if successful or an mbedtls error code.
+		*/
+		utl::mbed_err deserialize(const std::vector<unsigned char>& data, const std::string& hostname,
+			mbedtls_ssl_protocol_version version);
+
+	private:
+		// The class name
+		static const char* __class__;
+
+		// The saved session and the host that issued it.
+		mbedtls_ssl_session _session;
+		std::string _hostname;
+
+		// The protocol version negotiated when the session was saved.
+		mbedtls_ssl_protocol_version _version;
+
+		// True if a session is saved.
+		bool _valid;
+
+		// Mutex to serialize the access to the session.
+		utl::Mutex _mutex;
+
+		void reset();
+	};
+
+	using TlsSessionPtr = std::shared_ptr<TlsSession>;
+}
@@ -6,16 +6,29 @@
 *
 */
 #include "TlsSocket.h"
+#include <algorithm>
+#include "net/TlsMemory.h"
+#include "util/SysUtil.h"
 
 
 namespace net {
 	using namespace utl;
 
 
+	// Maximum size of a DTLS datagram sent during the handshake.
+	static constexpr uint16_t DTLS_MTU = 1400;
+
+	// Period (in ms) of the DTLS retransmission timer checks.
+	static constexpr uint32_t DTLS_POLL_TIME = 100;
+
+
 	TlsSocket::TlsSocket(const net::TlsConfig& tls_config) :
 		TcpSocket(),
 		_tlscfg{ tls_config },
-		_enable_hostname_verification{ false }
+		_enable_hostname_verification{ false },
+		_enable_crt_verification{ true },
+		_session(),
+		_session_host()
 	{
 		DEBUG_CTOR(_logger);
 	}
@@ -33,22 +46,64 @@ namespace net {
 	}
 
 
+	void TlsSocket::set_session_cache(const TlsSessionPtr& session)
+	{
+		_session = session;
+	}
+
+
+	void TlsSocket::set_crt_verification(bool enable_verification)
+	{
+		_enable_crt_verification = enable_verification;
+	}
+
+
+	bool TlsSocket::take_over(TlsSocket& other)
+	{
+		DEBUG_ENTER_FMT(_logger, "fd=%d", other.get_fd());
+
+		if (!other.is_connected() || &other._tlscfg != &_tlscfg || is_datagram())
+			return false;
+
+		// The SSL context refers to the configuration, the socket descriptor
+		// is moved first to rebind the context to this socket.
+		Socket::take_over(other);
+		_tlsctx.take_over(other._tlsctx, *netctx());
+		_session_host = other._session_host;
+
+		return true;
+	}
+
+
 	utl::mbed_err TlsSocket::connect(const Endpoint& ep, const utl::Timer& timer)
 	{
 		DEBUG_ENTER_FMT(_logger, "ep=%s", ep.to_string().c_str());
 
-		mbed_err rc = TcpSocket::connect(ep, timer);
+		mbed_err rc = is_datagram()
+			? datagram_connect(ep, timer)
+			: TcpSocket::connect(ep, timer);
 		if (rc)
 			goto terminate;
 
-		rc = _tlsctx.configure(*_tlscfg.get_cfg(), *netctx());
+		rc = _tlsctx.configure(*_tlscfg.get_cfg(_enable_crt_verification), *netctx());
 		if (rc)
 			goto terminate;
 
+		if (is_datagram()) {
+			rc = _tlsctx.configure_datagram(DTLS_MTU);
+			if (rc)
+				goto terminate;
+		}
+
 		rc = _tlsctx.set_hostname(ep.hostname());
 		if (rc)
 			goto terminate;
 
+		// Try to resume the last session established with this endpoint.
+		_session_host = ep.to_string();
+		if (_session && _tlsctx.restore_session(*_session, _session_host))
+			LOG_DEBUG(_logger, "resuming session with %s", _session_host.c_str());
+
 	terminate:
 		LOG_DEBUG(_logger, "fd=%d rc=%d", get_fd(), rc);
 			
@@ -60,11 +115,24 @@ namespace net {
 	{
 		DEBUG_ENTER(_logger);
 
+		// mbedtls flushes each handshake message separately.  The Nagle algorithm
+		// would hold the next messages of a flight until the first one is
+		// acknowledged, the peer delays this acknowledgment while it waits for
+		// the end of the flight.
+		bool no_delay = true;
+		if (!is_datagram() && get_nodelay(no_delay) == 0 && !no_delay)
+			set_nodelay(true);
+
+		const uint64_t start_time = utl::now_us();
+
 		tls_handshake_status handshake_status;
 		do {
 			LOG_TRACE(_logger, "call tlsctx.handshake");
 
 			handshake_status = _tlsctx.handshake();
+			while (handshake_status.status_code == hdk_status_code::SSLCTX_HDK_ERROR &&
+				save_new_ticket(handshake_status.rc))
+				handshake_status = _tlsctx.handshake();
 
 			LOG_TRACE(_logger, "return from tlsctx.handshake, status_code=%d rc=%d",
 				handshake_status.status_code,
@@ -72,9 +140,17 @@ namespace net {
 			);
 
 			if (handshake_status.status_code == hdk_status_code::SSLCTX_HDK_WAIT_IO) {
-				const poll_status poll_status = poll(handshake_status.rc, timer.remaining_time());
-
-				if (poll_status.code != poll_status_code::NETCTX_POLL_OK) {
+				// A DTLS handshake is resumed periodically to retransmit the lost flights.
+				const uint32_t wait_time = is_datagram()
+					? std::min(timer.remaining_time(), DTLS_POLL_TIME)
+					: timer.remaining_time();
+				const poll_status poll_status = poll(handshake_status.rc, wait_time);
+
+				if (is_datagram() && poll_status.rc == MBEDTLS_ERR_SSL_TIMEOUT && !timer.is_elapsed()) {
+					// Noop, the retransmission timer is checked by the handshake.
+					;
+				}
+				else if (poll_status.code != poll_status_code::NETCTX_POLL_OK) {
 					handshake_status.status_code = hdk_status_code::SSLCTX_HDK_ERROR;
 					handshake_status.rc = poll_status.rc;
 				}
@@ -99,6 +175,29 @@ namespace net {
 			handshake_status.rc
 		);
 
+		if (_logger->is_debug_enabled()) {
+			// The memory counters are shared by all the TLS contexts of the process.
+			const tls_memory_stats stats{ TlsMemory::get_stats() };
+
+			_logger->debug("... %s handshake time=%llu us, process TLS memory allocations=%llu pool hits=%llu in use=%zu peak=%zu",
+				__class__,
+				utl::now_us() - start_time,
+				stats.allocations,
+				stats.pool_hits,
+				stats.in_use,
+				stats.peak);
+		}
+
+		// Restore the option defined by the caller.
+		if (!no_delay)
+			set_nodelay(false);
+
+		// A TLS 1.2 session can be resumed as soon as the handshake is complete,
+		// a TLS 1.3 session is saved when the server sends a ticket.
+		if (handshake_status.status_code == hdk_status_code::SSLCTX_HDK_OK && _session &&
+			_tlsctx.get_tls_version_number() == MBEDTLS_SSL_VERSION_TLS1_2)
+			_tlsctx.save_session(*_session, _session_host);
+
 		return handshake_status;
 	}
 
@@ -170,17 +269,51 @@ namespace net {
 	}
 
 
+	utl::mbed_err TlsSocket::datagram_connect(const Endpoint& ep, const utl::Timer& timer)
+	{
+		mbed_err rc = Socket::connect(ep, net_protocol::NETCTX_PROTO_UDP, timer);
+		if (rc == 0)
+			rc = Socket::set_blocking_mode(false);
+
+		return rc;
+	}
+
+
 	net::rcv_status TlsSocket::recv_data(unsigned char* buf, const size_t len)
 	{
 		TRACE_ENTER_FMT(_logger, "buffer=0x%012Ix size=%zu", PTR_VAL(buf), len);
-		return _tlsctx.recv_data(buf, len);
+
+		net::rcv_status status = _tlsctx.recv_data(buf, len);
+		while (status.code == rcv_status_code::NETCTX_RCV_ERROR && save_new_ticket(status.rc))
+			status = _tlsctx.recv_data(buf, len);
+
+		return status;
 	}
 
 
 	net::snd_status TlsSocket::send_data(const unsigned char* buf, const size_t len)
 	{
 		TRACE_ENTER_FMT(_logger, "buffer=0x%012Ix size=%zu", PTR_VAL(buf), len);
-		return _tlsctx.send_data(buf, len);
+
+		// mbedtls processes a pending ticket before writing the data.
+		net::snd_status status = _tlsctx.send_data(buf, len);
+		while (status.code == snd_status_code::NETCTX_SND_ERROR && save_new_ticket(status.rc))
+			status = _tlsctx.send_data(buf, len);
+
+		return status;
+	}
+
+
+	bool TlsSocket::save_new_ticket(utl::mbed_err rc)
+	{
+		if (rc != MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET)
+			return false;
+
+		// The server sent a TLS 1.3 ticket, save it before resuming the operation.
+		if (_session)
+			_tlsctx.save_session(*_session, _session_host);
+
+		return true;
 	}
 
 
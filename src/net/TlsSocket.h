@@ -11,6 +11,7 @@
 #include <mbedtls/x509_crt.h>
 #include "net/TlsContext.h"
 #include "net/TlsConfig.h"
+#include "net/TlsSession.h"
 #include "net/TcpSocket.h"
 #include "net/Endpoint.h"
 
@@ -51,6 +52,53 @@ namespace net {
 		 */
 		void set_hostname_verification(bool enable_verification);
 
+		/**
+		 * Defines the session cache used by this socket.
+		 *
+		 * A session saved by a previous connection to the same endpoint is
+		 * offered to the server, the session negotiated by this connection
+		 * replaces it.  The cache must be configured before initiating the
+		 * connection to the endpoint.
+		 *
+		 * @param session The session cache, nullptr disables the resumption.
+		 */
+		void set_session_cache(const TlsSessionPtr& session);
+
+		/**
+		 * Enables or disables the verification of the server certificate chain.
+		 *
+		 * The verification can be disabled when the caller already trusts the
+		 * certificate presented by this server, the caller must then compare
+		 * the received certificate with the trusted one.  This flag must be
+		 * configured before initiating the connection to the endpoint.
+		 *
+		 * @param enable If `false`, the chain is not verified.
+		 */
+		void set_crt_verification(bool enable_verification);
+
+		/**
+		 * Takes over the established connection of another TLS socket.
+		 *
+		 * The connection, including the TLS context, is transferred to this
+		 * socket without a new handshake.  The other socket is left disconnected
+		 * and will establish a new connection if it is used again.  Both sockets
+		 * must share the same TLS configuration.
+		 *
+		 * @param other The socket that holds the connection.
+		 *
+		 * @return false if the other socket is not connected or if the TLS
+		 *         configurations differ.
+		 */
+		bool take_over(TlsSocket& other);
+
+		/**
+		 * Returns true if this socket uses a DTLS datagram transport.
+		 *
+		 * A datagram is sent for each call to `send_data` and `recv_data`
+		 * returns the content of one datagram.
+		 */
+		inline bool is_datagram() const noexcept { return _tlscfg.is_datagram(); }
+
 		/**
 		 * Initiates a connection to the specified endpoint.
 		 * See base class.
@@ -137,6 +185,21 @@ namespace net {
 
 		// True if the host name verification must be validated.
 		bool _enable_hostname_verification;
+
+		// True if the certificate chain must be verified.
+		bool _enable_crt_verification;
+
+		// The session cache and the endpoint the socket is connected to.
+		TlsSessionPtr _session;
+		std::string _session_host;
+
+		// Connects the UDP socket of a DTLS transport.
+		utl::mbed_err datagram_connect(const Endpoint& ep, const utl::Timer& timer);
+
+		// Saves the TLS 1.3 ticket received from the server if the error code
+		// signals a ticket, returns false for any other code.  The operation
+		// interrupted by the ticket must then be called again.
+		bool save_new_ticket(utl::mbed_err rc);
 	};
 
 }
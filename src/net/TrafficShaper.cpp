@@ -0,0 +1,69 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "TrafficShaper.h"
+
+#include <algorithm>
+#include <lwip/sys.h>
+
+
+namespace net {
+
+	TrafficShaper::TrafficShaper(const shaping_rates& rates, TrafficShaper* parent) :
+		_parent(parent),
+		_upload(rates.upload, sys_now()),
+		_download(rates.download, sys_now())
+	{
+	}
+
+
+	void TrafficShaper::refill() noexcept
+	{
+		const u32_t now = sys_now();
+
+		_upload.refill(now);
+		_download.refill(now);
+	}
+
+
+	size_t TrafficShaper::upload_quota() const noexcept
+	{
+		const size_t quota = _upload.available();
+		return _parent ? std::min(quota, _parent->upload_quota()) : quota;
+	}
+
+
+	size_t TrafficShaper::download_quota() const noexcept
+	{
+		const size_t quota = _download.available();
+		return _parent ? std::min(quota, _parent->download_quota()) : quota;
+	}
+
+
+	void TrafficShaper::consume_upload(size_t count) noexcept
+	{
+		_upload.consume(count);
+		if (_parent)
+			_parent->consume_upload(count);
+	}
+
+
+	void TrafficShaper::consume_download(size_t count) noexcept
+	{
+		_download.consume(count);
+		if (_parent)
+			_parent->consume_download(count);
+	}
+
+
+	bool TrafficShaper::is_enabled() const noexcept
+	{
+		const bool enabled = !(_upload.is_unlimited() && _download.is_unlimited());
+		return enabled || (_parent && _parent->is_enabled());
+	}
+
+}
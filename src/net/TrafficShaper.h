@@ -0,0 +1,88 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "util/TokenBucket.h"
+
+
+namespace net {
+
+	/**
+	* Data rates (in bytes per second) enforced by a traffic shaper.
+	* A value of 0 means that the rate is not limited.
+	*/
+	struct shaping_rates {
+		uint32_t upload = 0;		// from the local client to the remote host
+		uint32_t download = 0;		// from the remote host to the local client
+	};
+
+
+	/**
+	* TrafficShaper: limits the upload and download rates using token buckets.
+	*
+	* A shaper can be attached to a parent shaper. In that case, the quota
+	* is the minimum of the quotas of both shapers and the consumed bytes
+	* are charged to both. The Tunneler owns the tunnel wide shaper that
+	* is the parent of the shaper owned by each PortForwarder.
+	*
+	* The shaper never drops data, it only returns how many bytes can be
+	* transmitted. Buckets are refilled using the lwIP clock.
+	*/
+	class TrafficShaper final
+	{
+	public:
+		/**
+		 * Creates a traffic shaper.
+		 *
+		 * @param rates   The upload and download rates.
+		 * @param parent  An optional parent shaper, the parent must outlive this shaper.
+		*/
+		explicit TrafficShaper(const shaping_rates& rates, TrafficShaper* parent = nullptr);
+
+		/**
+		 * Refills the buckets of this shaper. The parent is not refilled.
+		*/
+		void refill() noexcept;
+
+		/**
+		 * Returns the number of bytes that can be uploaded.
+		*/
+		size_t upload_quota() const noexcept;
+
+		/**
+		 * Returns the number of bytes that can be downloaded.
+		*/
+		size_t download_quota() const noexcept;
+
+		/**
+		 * Charges uploaded bytes to this shaper and to its parent.
+		*/
+		void consume_upload(size_t count) noexcept;
+
+		/**
+		 * Charges downloaded bytes to this shaper and to its parent.
+		*/
+		void consume_download(size_t count) noexcept;
+
+		/**
+		 * Returns true if this shaper or its parent limits a rate.
+		*/
+		bool is_enabled() const noexcept;
+
+	private:
+		// The parent shaper or nullptr.
+		TrafficShaper* const _parent;
+
+		// Token buckets for each direction.
+		utl::TokenBucket _upload;
+		utl::TokenBucket _download;
+	};
+
+}
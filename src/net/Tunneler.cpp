@@ -8,10 +8,13 @@
 #include "Tunneler.h"
 
 #include <windows.h>
+#include <algorithm>
 #include <list>
 #include "net/DnsClient.h"
+#include "net/LoopStats.h"
 #include "net/PortForwarders.h"
 #include "util/ErrUtil.h"
+#include "util/SysUtil.h"
 
 
 static void timeout_cb(void* arg)
@@ -21,25 +24,40 @@ static void timeout_cb(void* arg)
 }
 
 
+// Interval between two refills of the tunnel token buckets (in ms).
+static constexpr u32_t SHAPER_INTERVAL = 20;
+
+static void shaper_cb(void* arg)
+{
+	net::TrafficShaper* shaper = static_cast<net::TrafficShaper*>(arg);
+	shaper->refill();
+
+	// This periodic timer also ensures that the tunneler wakes up 
+	// when forwarders are waiting for tokens.
+	sys_timeout(SHAPER_INTERVAL, shaper_cb, arg);
+}
+
+
 namespace net {
 	using namespace utl;
 
 
-	Tunneler::Tunneler(net::TlsSocket& tunnel, const net::Endpoint& local_ep, const net::Endpoint& remote_ep,
+	Tunneler::Tunneler(net::TlsSocket& tunnel, const net::Endpoint& local_ep, const net::Endpoints& remote_eps,
 		const tunneler_config& config) :
 		Thread(),
 		_logger(Logger::get_logger()),
 		_config(config),
 		_state(State::READY),
 		_terminate(false),
-		_tunnel(tunnel),
+		_tunnel(&tunnel),
 		_counters(),
 		_clients_count(0),
-		_pp_interface(tunnel, _counters),
+		_pp_interface(tunnel, _counters, config.ppp),
 		_listening_status(),
 		_local_endpoint(local_ep),
 		_listener(),
-		_remote_endpoint(remote_ep)
+		_backends(remote_eps, config.policy),
+		_shaper(config.tunnel_rates)
 	{
 		DEBUG_CTOR(_logger);
 	}
@@ -65,6 +83,12 @@ namespace net {
 			started = false;
 		}
 		else {
+			if (_config.early_listen) {
+				// Local clients are accepted as soon as the listener is bound, 
+				// they will be connected when the tunnel is up.
+				_listening_status.set();
+			}
+
 			started = Thread::start();
 		}
 
@@ -89,6 +113,21 @@ namespace net {
 	}
 
 
+	bool Tunneler::open_tunnel()
+	{
+		return _tunnel->is_connected();
+	}
+
+
+	void Tunneler::set_tunnel(net::TlsSocket& tunnel)
+	{
+		DEBUG_ENTER(_logger);
+
+		_tunnel = &tunnel;
+		_pp_interface.set_tunnel(tunnel);
+	}
+
+
 	unsigned int Tunneler::run()
 	{
 		DEBUG_ENTER(_logger);
@@ -99,47 +138,83 @@ namespace net {
 		FD_SET write_set;
 		timeval timeout;
 		PortForwarders active_port_forwarders;
-		bool connecting = false;
 		bool abort_timeout = false;
 		bool disconnect_timeout = false;
+		LoopStats loop_stats;
+		const uint64_t busy_poll = static_cast<uint64_t>(std::max(0, _config.busy_poll));
+		uint64_t last_event = 0;
 
 		_logger->info(">> starting tunnel");
 		_state = State::CONNECTING;
 
+		if (!_tunnel->is_connected() && !open_tunnel()) {
+			_listener.close();
+			_state = State::STOPPED;
+			return 0;
+		}
 
 		// Disable Nagle algorithm if required
-		_tunnel.set_nodelay(_config.tcp_nodelay);
+		if (!_tunnel->is_datagram())
+			_tunnel->set_nodelay(_config.tcp_nodelay);
 
 		if (!_pp_interface.open()) {
 			_state = State::STOPPED;
 			return 0;
 		}
 
+		// Start the rate limiter if a limit is configured.
+		const bool shaping = 
+			_config.tunnel_rates.upload > 0 || _config.tunnel_rates.download > 0 ||
+			_config.client_rates.upload > 0 || _config.client_rates.download > 0;
+		if (shaping) {
+			_logger->info(">> rate limits tunnel=%u/%u client=%u/%u bytes/s (upload/download)",
+				_config.tunnel_rates.upload,
+				_config.tunnel_rates.download,
+				_config.client_rates.upload,
+				_config.client_rates.download);
+
+			sys_timeout(SHAPER_INTERVAL, shaper_cb, &_shaper);
+		}
+
+		if (busy_poll > 0)
+			_logger->info(">> busy poll %llu us", busy_poll);
+		loop_stats.start();
+
 		while (!stop) {
 			FD_ZERO(&read_set);
 			FD_ZERO(&write_set);
 
 			// Define select conditions only if the tunnel is still connected.
-			if (_tunnel.is_connected()) {
+			if (_tunnel->is_connected()) {
 				if (_pp_interface.must_transmit()) {
 					// data is available in the output queue, check if we can write.
-					FD_SET(_tunnel.get_fd(), &write_set);
+					FD_SET(_tunnel->get_fd(), &write_set);
 				}
 
 				// always check if data is available from the tunnel.
-				FD_SET(_tunnel.get_fd(), &read_set);
-
-				if (_pp_interface.if4_up() && !connecting && 
-					active_port_forwarders.connected_count() < _config.max_clients) {
+				FD_SET(_tunnel->get_fd(), &read_set);
+
+				const size_t connecting_count = active_port_forwarders.connecting_count();
+				const size_t active_count = active_port_forwarders.connected_count() + 
+					active_port_forwarders.pending_count() + connecting_count;
+				if ((_pp_interface.if4_up() || (_config.early_listen && _state == State::CONNECTING)) &&
+					connecting_count < static_cast<size_t>(_config.max_connecting) &&
+					active_count < static_cast<size_t>(_config.max_clients)) {
 					// We are ready to accept a new connection only if the PPP interface
-					// is up, if we are not currently accepting a connection and the 
-					// max number of connected forwarders is not reached.
+					// is up (or is being negotiated in early listen mode), if the max 
+					// number of pending connections is not reached and the max number 
+					// of connected forwarders is not reached.
+					// Connections are established concurrently, a slow destination
+					// does not delay other clients.
 					FD_SET(_listener.get_fd(), &read_set);
 				}
 
 				for (auto pf : active_port_forwarders) {
 					const int fd = pf->get_fd();
 
+					// Update the quotas of this forwarder.
+					pf->shape();
+
 					if (pf->is_connected()) {
 						// Do we have data to send or to reply ?
 						if (pf->can_receive_data())
@@ -155,13 +230,22 @@ namespace net {
 					}
 				}
 
-				// Determine how long we sleep in the select.
-				compute_sleep_time(timeout);
+				// Determine how long we sleep in the select.  The sockets are polled
+				// without blocking as long as the busy poll budget is not exhausted.
+				const bool spinning = busy_poll > 0 && utl::now_us() - last_event < busy_poll;
+				if (spinning) {
+					timeout.tv_sec = 0;
+					timeout.tv_usec = 0;
+				}
+				else {
+					compute_sleep_time(timeout);
+				}
 
 				// Wait for a network event or timeout.
 				rc = select(0, &read_set, &write_set, nullptr, &timeout);
 				if (rc > 0) {
-					if (FD_ISSET(_tunnel.get_fd(), &write_set)) {
+					last_event = utl::now_us();
+					if (FD_ISSET(_tunnel->get_fd(), &write_set)) {
 						// Send PPP through the tunnel 
 						if (!_pp_interface.send()) {
 							shutdown_tunnel();
@@ -169,7 +253,7 @@ namespace net {
 						}
 					}
 
-					if (FD_ISSET(_tunnel.get_fd(), &read_set)) {
+					if (FD_ISSET(_tunnel->get_fd(), &read_set)) {
 						// Receive PPP data from the tunnel.
 						if (!_pp_interface.recv()) {
 							_logger->info(">> tunnel closed by peer");
@@ -180,11 +264,20 @@ namespace net {
 
 					if (FD_ISSET(_listener.get_fd(), &read_set)) {
 						// Accept a new connection.
-						PortForwarder* pf = new PortForwarder(_remote_endpoint, _config.tcp_nodelay, true);
-
-						if (pf->connect(_listener)) {
-							// A new port forwarder is active.
-							connecting = true;
+						const forwarder_config pf_config {
+							_config.tcp_nodelay, 
+							true, 
+							static_cast<uint32_t>(_config.connect_timeout),
+							_config.client_rates,
+							compute_rto_min(),
+							static_cast<uint32_t>(_config.ack_delay),
+							static_cast<uint32_t>(_config.quick_acks)
+						};
+						PortForwarder* pf = new PortForwarder(_backends, pf_config, _shaper);
+
+						if (pf->accept(_listener) && (!_pp_interface.if4_up() || pf->connect())) {
+							// A new port forwarder is active or waits until the
+							// PPP interface is up.
 							active_port_forwarders.push_back(pf);
 						}
 						else {
@@ -215,6 +308,8 @@ namespace net {
 						}
 					}
 
+					// Record the time spent processing the ready sockets.
+					loop_stats.record(utl::now_us() - last_event, spinning);
 				}
 				else if (rc == 0) {
 					// timeout, noop
@@ -232,9 +327,9 @@ namespace net {
 			// The pppossl_netif_output function is called, which in turn calls
 			// the ppp_output_cb callback registered when the PPP interface was created.
 			for (auto pf : active_port_forwarders) {
-				if (pf->has_connection_timed_out()) {
-					// Abort all forwarders in connection time out
-					pf->abort();
+				if (pf->has_connection_failed()) {
+					// The backend did not respond, try the next one.
+					pf->failover();
 				}
 
 				if (pf->is_connected()) {
@@ -261,6 +356,9 @@ namespace net {
 			case State::CONNECTING:
 				if (_terminate) {
 					_state = State::CLOSING;
+
+					// Drop the clients waiting for the tunnel.
+					active_port_forwarders.delete_having_state([](const PortForwarder* pf) {return pf->is_pending(); });
 				}
 				else if (_pp_interface.if4_up()) {
 					// The listener is now accepting inbound connection.
@@ -284,6 +382,9 @@ namespace net {
 			case State::RUNNING:
 				if (_terminate) {
 					_state = State::CLOSING;
+
+					// Drop the clients waiting for a connection.
+					active_port_forwarders.delete_having_state([](const PortForwarder* pf) {return pf->is_pending(); });
 					
 					// Abort all port forwarders (send a RST packet)
 					abort_timeout = false;
@@ -294,13 +395,19 @@ namespace net {
 					}
 				}
 				else {
-					_pp_interface.send_keep_alive();
+					// Connect the clients accepted while the PPP link was negotiated.
+					size_t connecting_count = active_port_forwarders.connecting_count();
+					for (auto pf : active_port_forwarders) {
+						if (connecting_count >= static_cast<size_t>(_config.max_connecting))
+							break;
 
-					// A port forwarder connection was started.
-					if (connecting) {
-						// Is the connection still pending ?
-						connecting = active_port_forwarders.has_connecting_forwarders();
+						if (pf->is_pending()) {
+							pf->connect();
+							connecting_count++;
+						}
 					}
+
+					_pp_interface.send_keep_alive();
 				}
 
 				break;
@@ -309,7 +416,7 @@ namespace net {
 				if (active_port_forwarders.empty() || abort_timeout) {
 					// All connections are closed, shutdown the ppp interface
 					_state = State::DISCONNECTING;
-					_pp_interface.close(!_tunnel.is_connected());
+					_pp_interface.close(!_tunnel->is_connected());
 
 					// Set a timer to ensure the thread exits. The timeout is deliberately
 					// longer than SyncDisconnect's timeout. If the interface remains active,
@@ -340,6 +447,7 @@ namespace net {
 		_pp_interface.release();
 		sys_untimeout(timeout_cb, &abort_timeout);
 		sys_untimeout(timeout_cb, &disconnect_timeout);
+		sys_untimeout(shaper_cb, &_shaper);
 
 		// Close the listening socket.
 		_listener.close();
@@ -348,6 +456,7 @@ namespace net {
 		shutdown_tunnel();
 
 		LOG_DEBUG(_logger, "closing tunneler stop=%d terminate=%d", stop, _terminate);
+		loop_stats.report(_logger, busy_poll > 0 ? LogLevel::LL_INFO : LogLevel::LL_DEBUG);
 
 		_state = State::STOPPED;
 
@@ -370,9 +479,24 @@ namespace net {
 		return;
 	}
 
+	uint32_t Tunneler::compute_rto_min() const
+	{
+		// A segment sent through the tunnel is delayed, not lost, when the outer
+		// connection recovers from a loss.  The inner RTO must exceed the outer
+		// retransmission time, a few outer RTT.  The mode is disabled (0) if
+		// the RTT of the outer connection is not available.  A DTLS tunnel
+		// does not retransmit, a segment lost outside is really lost.
+		uint32_t rtt = 0;
+		if (!_config.tcp_tunnel_mode || _tunnel->is_datagram() || !_tunnel->get_rtt(rtt) || rtt == 0)
+			return 0;
+
+		return std::min<uint32_t>(std::max<uint32_t>(4 * rtt, 1000), 8000);
+	}
+
+
 	void Tunneler::shutdown_tunnel()
 	{
-		const mbed_err rc = _tunnel.shutdown();
+		const mbed_err rc = _tunnel->shutdown();
 		if (rc)
 			_logger->error("ERROR: close notify error (%d)", rc);
 	}
@@ -7,10 +7,12 @@
 */
 #pragma once
 
+#include "net/BackendPool.h"
 #include "net/Endpoint.h"
 #include "net/TlsSocket.h"
 #include "net/Listener.h"
 #include "net/PPInterface.h"
+#include "net/TrafficShaper.h"
 #include "util/Counters.h"
 #include "util/Thread.h"
 #include "util/Logger.h"
@@ -20,9 +22,49 @@
 namespace net {
 
 	struct tunneler_config {
-		bool tcp_nodelay;
-		int  max_clients;
-		int  connect_timeout;
+		bool tcp_nodelay = false;
+		int  max_clients = 1;
+
+		// Connection timeout to a remote endpoint (in ms).  When the timeout
+		// expires, the forwarder fails over to the next endpoint.
+		int  connect_timeout = 10 * 1000;
+
+		// Policy used to select a remote endpoint.
+		balancing_policy policy = balancing_policy::FAILOVER;
+
+		// Maximum number of connections established simultaneously.
+		int  max_connecting = 8;
+
+		// Rate limits applied to the whole tunnel and to each client connection.
+		shaping_rates tunnel_rates;
+		shaping_rates client_rates;
+
+		// Accept local clients before the PPP link is up.  Clients are kept
+		// pending until the tunnel is ready.
+		bool early_listen = false;
+
+		// PPP negotiation parameters.
+		ppp_config ppp;
+
+		// Delayed acknowledgment policy of the connections inside the tunnel.
+		// The first segments received after an idle period are acknowledged
+		// immediately, the next ones after ack_delay (in ms).  An ack_delay
+		// of 0 keeps the lwIP policy.
+		int  ack_delay = 20;
+		int  quick_acks = 16;
+
+		// Busy poll budget (in us).  After a network event, the loop polls the
+		// sockets without blocking during this delay.  0 disables the busy poll.
+		int  busy_poll = 0;
+
+		// Enables the TCP over TCP aware mode of the connections inside the
+		// tunnel when the RTT of the outer connection is known.
+		bool tcp_tunnel_mode = true;
+
+		// Open the tunnel on the authenticated connection of the portal instead
+		// of a new connection.  Ignored when early_listen is set, the tunnel is
+		// then opened when the first client connects.
+		bool reuse_connection = false;
 	};
 
 	class Tunneler : public utl::Thread
@@ -32,14 +74,14 @@ namespace net {
 		* Creates a Tunneler instance.
 		*
 		* The Tunneler forwards traffic received on the specified local endpoint
-		* to the remote endpoint through a secure, encrypted tunnel.
+		* to one of the remote endpoints through a secure, encrypted tunnel.
 		*
 		* @param tunnel  The TLS socket used for secure communication.
 		* @param local   The local network endpoint to listen for incoming traffic.
-		* @param remote  The remote network endpoint to forward traffic to.
+		* @param remotes The remote network endpoints to forward traffic to.
 		* @param config  Configuration settings for the tunneler.
 		*/
-		explicit Tunneler(net::TlsSocket& tunnel, const net::Endpoint& local, const net::Endpoint& remote,
+		explicit Tunneler(net::TlsSocket& tunnel, const net::Endpoint& local, const net::Endpoints& remotes,
 			const tunneler_config& config);
 		
 		/**
@@ -101,6 +143,25 @@ namespace net {
 	protected:
 		unsigned int run() override;
 
+		/**
+		 * Opens the tunnel socket.  This function is called by the tunneler 
+		 * thread when the tunnel socket is not yet connected.
+		 * 
+		 * @return true if the tunnel is open.
+		*/
+		virtual bool open_tunnel();
+
+		/**
+		 * Returns the tunneler configuration.
+		*/
+		inline const tunneler_config& config() const noexcept { return _config; }
+
+		/**
+		 * Replaces the socket that carries the tunnel.  The function must be
+		 * called by open_tunnel, before the PPP interface is opened.
+		*/
+		void set_tunnel(net::TlsSocket& tunnel);
+
 	private:
 		// The class name
 		static const char* __class__;
@@ -118,7 +179,7 @@ namespace net {
 		volatile bool _terminate;
 
 		// Tunnel socket.
-		net::TlsSocket&  _tunnel;
+		net::TlsSocket*  _tunnel;
 
 		// Counters of bytes sent to / received from the tunnel.
 		utl::Counters _counters;
@@ -136,10 +197,14 @@ namespace net {
 		const net::Endpoint _local_endpoint;
 		net::Listener _listener;
 
-		// The remote end point (protected by the firewall).
-		net::Endpoint _remote_endpoint;
+		// The remote end points (protected by the firewall).
+		net::BackendPool _backends;
+
+		// The tunnel wide rate limiter.
+		net::TrafficShaper _shaper;
 
 		void compute_sleep_time(timeval& timeout) const;
+		uint32_t compute_rto_min() const;
 		void shutdown_tunnel();
 	};
 
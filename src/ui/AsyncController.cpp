@@ -28,10 +28,14 @@ namespace ui {
 		_requestEvent(false),
 		_readyEvent(false),
 		_hwnd(hwnd),
-		_ca_crt(),
+		_ca_store(),
 		_user_crt(),
 		_auth_method(fw::AuthMethod::BASIC),
-		_tls_config()
+		_session_cache(false),
+		_dtls(false),
+		_tls_config(),
+		_dtls_config(net::net_protocol::NETCTX_PROTO_UDP),
+		_crt_cache()
 	{
 		DEBUG_CTOR(_logger);
 		start();
@@ -49,14 +53,14 @@ namespace ui {
 		DEBUG_ENTER(_logger);
 		bool init_status = true;
 
-		if (!_ca_crt) {
+		if (!_ca_store) {
 			const std::string crt_filename = utl::str::wstr2str(filename.to_string());
 			const std::string compacted = utl::str::wstr2str(filename.compact(40));
 
-			_ca_crt = std::make_unique<utl::X509Crt>();
+			_ca_store = std::make_unique<utl::CaStore>();
 
 			if (utl::Path::exists(filename)) {
-				utl::mbed_err rc = _ca_crt->load(crt_filename.c_str());
+				utl::mbed_err rc = _ca_store->load(crt_filename.c_str());
 
 				if (rc != 0) {
 					_logger->info("WARNING: failed to load CA cert file %s ", compacted.c_str());
@@ -64,7 +68,9 @@ namespace ui {
 					init_status = false;
 				}
 				else {
-					_logger->info(">> CA cert loaded from file '%s'", compacted.c_str());
+					_logger->info(">> %zu CA certs loaded from file '%s'", _ca_store->size(), compacted.c_str());
+					if (_ca_store->skipped() > 0)
+						_logger->info("WARNING: %zu invalid CA certs skipped", _ca_store->skipped());
 					init_status = true;
 				}
 			}
@@ -131,15 +137,46 @@ namespace ui {
 	}
 
 
+	void AsyncController::set_session_cache(bool enable)
+	{
+		_session_cache = enable;
+	}
+
+
+	void AsyncController::set_aead_benchmark(bool enable)
+	{
+		// The benchmark is computed once, both transports use its result.
+		_tls_config.set_aead_preference(enable);
+		_dtls_config.set_aead_preference(enable);
+	}
+
+
+	void AsyncController::set_dtls(bool enable)
+	{
+		_dtls = enable;
+	}
+
+
 	bool AsyncController::connect(const net::Endpoint& firewall_endpoint, const std::string& realm)
 	{
 		DEBUG_ENTER_FMT(_logger, "ep=%s realm=%s", firewall_endpoint.to_string().c_str(), realm.c_str());
 
 		// Start the async connect procedure.
-		_tls_config.set_ca_crt(_ca_crt->get_crt());
+		_tls_config.set_ca_store(*_ca_store);
 		if (_auth_method == fw::AuthMethod::CERTIFICATE && _user_crt)
 			_tls_config.set_user_crt(_user_crt->crt.get_crt(), _user_crt->pk.get_pk());
 		_portal_client = std::make_unique<fw::FirewallClient>(firewall_endpoint, realm, _tls_config);
+		_portal_client->set_crt_cache(&_crt_cache);
+		if (_session_cache) {
+			const utl::Path store_path{ utl::Path::get_appdata_path().folder() + L"FortiRDP\\", L"sessions.dat" };
+			_portal_client->set_session_store(store_path);
+		}
+		if (_dtls) {
+			_dtls_config.set_ca_store(*_ca_store);
+			if (_auth_method == fw::AuthMethod::CERTIFICATE && _user_crt)
+				_dtls_config.set_user_crt(_user_crt->crt.get_crt(), _user_crt->pk.get_pk());
+			_portal_client->set_dtls_config(&_dtls_config);
+		}
 
 		request_action(AsyncController::CONNECT);
 
@@ -147,10 +184,10 @@ namespace ui {
 	}
 
 
-	bool AsyncController::create_tunnel(const net::Endpoint& remote_endpoint, uint16_t local_port,
-		bool multi_clients, bool tcp_nodelay)
+	bool AsyncController::create_tunnel(const net::Endpoints& remote_endpoints, uint16_t local_port,
+		const net::tunneler_config& config)
 	{
-		DEBUG_ENTER_FMT(_logger, "ep=%s", remote_endpoint.to_string().c_str());
+		DEBUG_ENTER_FMT(_logger, "ep=%s", remote_endpoints.front().to_string().c_str());
 
 		_tunnel.reset();
 
@@ -160,11 +197,8 @@ namespace ui {
 			const std::string localhost = "127.0.0.1";
 			const net::Endpoint local_endpoint(localhost, local_port);
 
-			// Configure the tunneler.
-			const net::tunneler_config config { tcp_nodelay, multi_clients ? 32 : 1 };
-
 			// Create a SSL tunnel from this host to the firewall and assign it to local pointer.
-			_tunnel.reset(_portal_client->create_tunnel(local_endpoint, remote_endpoint, config));
+			_tunnel.reset(_portal_client->create_tunnel(local_endpoint, remote_endpoints, config));
 
 			// Start the tunnel.
 			request_action(AsyncController::TUNNEL);
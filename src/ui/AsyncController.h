@@ -24,6 +24,7 @@
 #include "util/TaskInfo.h"
 #include "util/Task.h"
 #include "util/UserCrt.h"
+#include "util/CaStore.h"
 #include "util/X509Crt.h"
 
 
@@ -61,6 +62,22 @@ namespace ui {
 		*/
 		void set_auth_method(fw::AuthMethod auth_method);
 
+		/**
+		 * Enables or disables the persistent TLS session store.
+		*/
+		void set_session_cache(bool enable);
+
+		/**
+		 * Selects the preferred AEAD cipher with a benchmark instead of the
+		 * processor capabilities.
+		*/
+		void set_aead_benchmark(bool enable);
+
+		/**
+		 * Enables or disables the DTLS tunnel transport.
+		*/
+		void set_dtls(bool enable);
+
 		/**
 		 * Connects this controller to the firewall
 		 *
@@ -70,8 +87,13 @@ namespace ui {
 
 		/**
 		 * Creates a tunnel with the firewall.
+		 *
+		 * @param remote_endpoints The remote endpoints protected by the firewall.
+		 * @param local_port       The local listening port, 0 to select a free port.
+		 * @param config           The tunneler configuration.
 		*/
-		bool create_tunnel(const net::Endpoint& remote_endpoint, uint16_t local_port, bool multi_clients, bool tcp_nodelay);
+		bool create_tunnel(const net::Endpoints& remote_endpoints, uint16_t local_port, 
+			const net::tunneler_config& config);
 
 		/**
 		 * Starts an external task. 
@@ -135,8 +157,8 @@ namespace ui {
 		// Tthe recipient window of the user event message sent at completion of an action.
 		const HWND _hwnd;
 
-		// The CA certificate chains.
-		utl::X509crtPtr _ca_crt;
+		// The CA certificates.
+		utl::CaStorePtr _ca_store;
 
 		// The user certificate.
 		utl::UserCrtPtr _user_crt;
@@ -144,9 +166,21 @@ namespace ui {
 		// The authentication method.
 		fw::AuthMethod _auth_method;
 
+		// True if the TLS sessions are saved across executions.
+		bool _session_cache;
+
+		// True if the tunnel is opened over DTLS when the firewall supports it.
+		bool _dtls;
+
 		// The TLS configuration.
 		net::TlsConfig _tls_config;
 
+		// The DTLS configuration.
+		net::TlsConfig _dtls_config;
+
+		// The certificates verified by the previous connections.
+		fw::CrtCache _crt_cache;
+
 		std::unique_ptr<fw::FirewallClient> _portal_client;
 		std::unique_ptr<fw::FirewallTunnel> _tunnel;
 		std::unique_ptr<utl::Task> _task;
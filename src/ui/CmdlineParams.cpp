@@ -10,6 +10,7 @@
 #include <cstdint>
 #include <iostream>
 #include <limits>
+#include <vector>
 #include <Windows.h>
 #include "util/Path.h"
 #include "util/SysUtil.h"
@@ -18,6 +19,35 @@
 
 namespace ui {
 
+	// Parses a rate limit specified as upload[:download] in KB/s.  If the
+	// download rate is omitted, the same limit applies to both directions.
+	static bool parse_rates(const std::wstring& arg, net::shaping_rates& rates)
+	{
+		std::vector<std::wstring> parts;
+		if (utl::str::split(arg, L':', parts) > 2)
+			return false;
+
+		int upload = -1;
+		int download = -1;
+		if (!utl::str::str2i(utl::str::trim(parts[0]), upload))
+			return false;
+		if (parts.size() == 1)
+			download = upload;
+		else if (!utl::str::str2i(utl::str::trim(parts[1]), download))
+			return false;
+
+		// Limit the rate to 1 GB/s to avoid an overflow.
+		const int max_rate = 1024 * 1024;
+		if (upload < 0 || upload > max_rate || download < 0 || download > max_rate)
+			return false;
+
+		rates.upload = static_cast<uint32_t>(upload) * 1024;
+		rates.download = static_cast<uint32_t>(download) * 1024;
+
+		return true;
+	}
+
+
 	bool CmdlineParams::initialize()
 	{
 		bool rc = true;
@@ -47,6 +77,7 @@ namespace ui {
 		_multimon_mode = false;
 		_screen_size = { 0, 0 };
 		_clear_lastuser = false;
+		_early_listen = false;
 
 		_verbose = false;
 		_trace = false;
@@ -61,11 +92,16 @@ namespace ui {
 		_local_port = 0;
 		_rdp_filename = L"";
 		_tcp_nodelay = false;
+		_client_rates = {};
+		_tunnel_rates = {};
+		_has_client_rates = false;
+		_has_tunnel_rates = false;
+		_balancing_policy = net::balancing_policy::FAILOVER;
 
 		int port = 0;
 
 		int c;
-		while ((c = getopt(argc, argv, L"?u:famvc:tx:p:sr:lCMnw:h:U:A:")) != EOF) {
+		while ((c = getopt(argc, argv, L"?u:famvc:tx:p:sr:lCMnew:h:U:A:b:B:P:")) != EOF) {
 			switch (c) {
 			case L'?':
 				return false;
@@ -127,6 +163,10 @@ namespace ui {
 				_tcp_nodelay = true;
 				break;
 
+			case L'e':
+				_early_listen = true;
+				break;
+
 			case L'w':
 				if (!str::str2i(optarg, _screen_size.width))
 					_screen_size.width = -1;
@@ -141,6 +181,29 @@ namespace ui {
 				_us_cert_filename = str::trim(optarg);
 				break;
 
+			case L'b':
+				if (!parse_rates(optarg, _client_rates))
+					return false;
+				_has_client_rates = true;
+				break;
+
+			case L'B':
+				if (!parse_rates(optarg, _tunnel_rates))
+					return false;
+				_has_tunnel_rates = true;
+				break;
+
+			case L'P':
+				if (std::wstring(optarg).compare(L"failover") == 0)
+					_balancing_policy = net::balancing_policy::FAILOVER;
+				else if (std::wstring(optarg).compare(L"roundrobin") == 0)
+					_balancing_policy = net::balancing_policy::ROUND_ROBIN;
+				else if (std::wstring(optarg).compare(L"leastconn") == 0)
+					_balancing_policy = net::balancing_policy::LEAST_CONNECTIONS;
+				else
+					return false;
+				break;
+
 			case L'A':
 				if (std::wstring(optarg).compare(L"basic") == 0)
 					_auth_method = fw::AuthMethod::BASIC;
@@ -236,7 +299,8 @@ namespace ui {
 		// Show program parameters.
 		std::cout << utl::str::string_format("fortirdp %s (jn.meurisse@gmail.com)\n\n", version.c_str());
 		std::cout << "fortirdp [-v [-t]] [-A auth] [-u username] [-c cacert_file] [-x app] [-f] [-a] [-s] [-p port]\n";
-		std::cout << "         [-r rdp_file] [-m] [-l] [-C] [-M] [-n] firewall-ip[:port1] remote-ip[:port2]\n";
+		std::cout << "         [-r rdp_file] [-m] [-l] [-C] [-M] [-n] [-e] [-b rate] [-B rate]\n";
+		std::cout << "         [-P policy] firewall-ip[:port1] remote-ip[:port2][,remote-ip[:port2]...]\n";
 		std::cout << "\n";
 		std::cout << "Options :\n";
 		std::cout << "\t-v             Verbose mode (use -t to trace tls conversation, high verbosity !)\n";
@@ -262,12 +326,21 @@ namespace ui {
 		std::cout << "\t-C             Specifies to clear the last rdp session username.\n";
 		std::cout << "\t-M             Specifies that the tunnel can accept multiple client connections.\n";
 		std::cout << "\t-n             Disables the Nagle algorithm.\n";
+		std::cout << "\t-e             Starts the application while the tunnel is being established.\n";
+		std::cout << "\t-b rate        Limits the rate of each client connection. The rate is specified in KB/s\n";
+		std::cout << "\t               with the syntax upload[:download]. If download is omitted, the same limit\n";
+		std::cout << "\t               applies to both directions. A value of 0 means unlimited.\n";
+		std::cout << "\t-B rate        Limits the rate of the whole tunnel (same syntax as -b).\n";
+		std::cout << "\t-P policy      Specifies how a remote host is selected when several hosts are specified\n";
+		std::cout << "\t               (failover, roundrobin, leastconn). The default policy is failover.\n";
 		std::cout << "\tfirewall-ip    Specifies the hostname or IP address of the firewall to connect to.\n";
 		std::cout << "\t               By default, the connection is done on port 10443. The 'port1' parameter\n";
 		std::cout << "\t               allows to specify another port number on the firewall.\n";
 		std::cout << "\tremote-ip      Specifies the IP address of the computer to connect to.\n";
 		std::cout << "\t               By default, the RDP connection is done on port 3389. The 'port2' parameter\n";
 		std::cout << "\t               allows to specify another port number on the terminal server.\n";
+		std::cout << "\t               A comma separated list of hosts can be specified, a host that does not\n";
+		std::cout << "\t               respond is skipped and the next one is tried.\n";
 		std::cout << "\n";
 	}
 
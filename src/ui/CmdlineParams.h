@@ -10,6 +10,8 @@
 #include <cstdint>
 #include <string>
 #include "fw/AuthTypes.h"
+#include "net/BackendPool.h"
+#include "net/TrafficShaper.h"
 #include "ScreenSize.h"
 
 
@@ -127,6 +129,11 @@ namespace ui {
 		*/
 		inline bool tcp_nodelay() const { return _tcp_nodelay; }
 
+		/**
+		 * Returns true if local clients are accepted before the tunnel is up.
+		*/
+		inline bool early_listen() const { return _early_listen; }
+
 		/**
 		 * Returns true if deletion of last used username from mstsc login window
 		 * option is enabled.
@@ -134,6 +141,34 @@ namespace ui {
 		*/
 		inline bool clear_rdp_username() const { return _clear_lastuser; }
 
+		/**
+		 * Returns the rate limits applied to each client connection.
+		*/
+		inline const net::shaping_rates& client_rates() const { return _client_rates; }
+
+		/**
+		 * Returns true if the rate limits of each client connection are
+		 * specified on the command line, a rate of 0 disables the limit.
+		*/
+		inline bool has_client_rates() const { return _has_client_rates; }
+
+		/**
+		 * Returns the rate limits applied to the whole tunnel.
+		*/
+		inline const net::shaping_rates& tunnel_rates() const { return _tunnel_rates; }
+
+		/**
+		 * Returns true if the rate limits of the whole tunnel are specified
+		 * on the command line, a rate of 0 disables the limit.
+		*/
+		inline bool has_tunnel_rates() const { return _has_tunnel_rates; }
+
+		/**
+		 * Returns the policy used to select a remote host when several
+		 * hosts are specified.
+		*/
+		inline net::balancing_policy balancing_policy() const { return _balancing_policy; }
+
 		/**
 		 * Returns if debug logs mode is enabled.
 		*/
@@ -156,6 +191,11 @@ namespace ui {
 		std::wstring _rdp_filename;
 		ScreenSize _screen_size{ 0,0 };
 		uint16_t _local_port = 0;
+		net::shaping_rates _client_rates;
+		net::shaping_rates _tunnel_rates;
+		bool _has_client_rates = false;
+		bool _has_tunnel_rates = false;
+		net::balancing_policy _balancing_policy = net::balancing_policy::FAILOVER;
 
 		// Command line options
 		bool _full_screen = false;
@@ -165,6 +205,7 @@ namespace ui {
 		bool _multimon_mode = false;
 		bool _clear_lastuser = false;
 		bool _tcp_nodelay = false;
+		bool _early_listen = false;
 
 		bool _verbose = false;
 		bool _trace = false;
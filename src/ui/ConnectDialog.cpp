@@ -215,6 +215,15 @@ namespace ui {
 	}
 
 
+	// Returns the rates from the command line if specified, otherwise the
+	// rates from the registry.  A rate of 0 on the command line removes the
+	// limit defined in the registry.
+	static net::shaping_rates get_rates(bool has_params, const net::shaping_rates& params, const net::shaping_rates& settings)
+	{
+		return has_params ? params : settings;
+	}
+
+
 	void ConnectDialog::connect(bool clear_log)
 	{
 		using namespace utl;
@@ -243,8 +252,13 @@ namespace ui {
 		}
 
 		try {
-			std::string host_addr = str::trim(str::wstr2str(getHostAddress()));
-			_host_endpoint = net::Endpoint(host_addr, DEFAULT_RDP_PORT);
+			// The host address can contain a comma separated list of endpoints.
+			std::vector<std::string> host_addrs;
+			str::split(str::trim(str::wstr2str(getHostAddress())), ',', host_addrs);
+
+			_host_endpoints.clear();
+			for (const std::string& host_addr : host_addrs)
+				_host_endpoints.push_back(net::Endpoint(str::trim(host_addr), DEFAULT_RDP_PORT));
 
 		}
 		catch (const std::invalid_argument&) {
@@ -322,6 +336,9 @@ namespace ui {
 			auth_method = _settings.get_auth_method();
 		}
 		_controller->set_auth_method(auth_method);
+		_controller->set_session_cache(_settings.get_session_cache());
+		_controller->set_aead_benchmark(_settings.get_aead_benchmark());
+		_controller->set_dtls(_settings.get_dtls());
 
 		//  Load user certificate file.
 		if (_params.us_cert_filename().length() > 0) {
@@ -826,12 +843,29 @@ namespace ui {
 
 			_logger->info(">> successfully logged in portal %s", _firewall_endpoint.to_string().c_str());
 
+			// Configure the tunneler.  Rate limits specified on the command line
+			// take precedence over the registry settings.
+			net::tunneler_config config;
+			config.tcp_nodelay = _params.tcp_nodelay();
+			config.max_clients = _params.multi_clients() ? 32 : 1;
+			config.max_connecting = _settings.get_max_connecting();
+			config.policy = _params.balancing_policy();
+			config.early_listen = _params.early_listen();
+			config.ppp = _settings.get_ppp_config();
+			config.ack_delay = _settings.get_ack_delay();
+			config.quick_acks = _settings.get_quick_acks();
+			config.busy_poll = _settings.get_busy_poll();
+			config.tcp_tunnel_mode = _settings.get_tcp_tunnel_mode();
+			config.reuse_connection = _settings.get_reuse_connection();
+			if (_host_endpoints.size() > 1) {
+				// Do not wait too long before failing over to the next host.
+				config.connect_timeout = 3 * 1000;
+			}
+			config.client_rates = get_rates(_params.has_client_rates(), _params.client_rates(), _settings.get_client_rates());
+			config.tunnel_rates = get_rates(_params.has_tunnel_rates(), _params.tunnel_rates(), _settings.get_tunnel_rates());
+
 			// create the tunnel.
-			_controller->create_tunnel(
-				_host_endpoint,
-				_params.local_port(),
-				_params.multi_clients(),
-				_params.tcp_nodelay());
+			_controller->create_tunnel(_host_endpoints, _params.local_port(), config);
 
 			// Start network activity tracking.
 			_previous_counters = 0;
@@ -75,9 +75,9 @@ namespace ui {
 		// - Firewall sslvpn realm
 		std::wstring _realm;
 
-		// - Host endpoint
+		// - Host endpoints
 		const uint16_t DEFAULT_RDP_PORT = 3389;
-		net::Endpoint _host_endpoint;
+		net::Endpoints _host_endpoints;
 
 		// - User name
 		std::wstring _username;
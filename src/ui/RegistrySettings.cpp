@@ -206,6 +206,95 @@ namespace ui {
 	}
 
 
+	net::shaping_rates RegistrySettings::get_client_rates() const
+	{
+		net::shaping_rates rates;
+		rates.upload = get_rate(CLIENT_UPLOAD_RATE);
+		rates.download = get_rate(CLIENT_DOWNLOAD_RATE);
+
+		return rates;
+	}
+
+
+	net::shaping_rates RegistrySettings::get_tunnel_rates() const
+	{
+		net::shaping_rates rates;
+		rates.upload = get_rate(TUNNEL_UPLOAD_RATE);
+		rates.download = get_rate(TUNNEL_DOWNLOAD_RATE);
+
+		return rates;
+	}
+
+
+	int RegistrySettings::get_max_connecting() const
+	{
+		return std::min(32, std::max(1, get_int(MAX_CONNECTING, 8)));
+	}
+
+
+	net::ppp_config RegistrySettings::get_ppp_config() const
+	{
+		net::ppp_config config;
+		config.restart_timeout = static_cast<uint8_t>(
+			std::min(30, std::max(1, get_int(PPP_RESTART_TIMEOUT, config.restart_timeout))));
+		config.max_configure = static_cast<uint8_t>(
+			std::min(20, std::max(1, get_int(PPP_MAX_CONFIGURE, config.max_configure))));
+		config.seed_addresses = get_int(PPP_SEED_ADDRESSES, 1) != 0;
+		config.skip_rx_checksum = get_bool(SKIP_RX_CHECKSUM);
+		config.adaptive_records = get_int(ADAPTIVE_RECORDS, 1) != 0;
+
+		return config;
+	}
+
+
+	int RegistrySettings::get_ack_delay() const
+	{
+		return std::min(200, std::max(0, get_int(ACK_DELAY, 20)));
+	}
+
+
+	int RegistrySettings::get_quick_acks() const
+	{
+		return std::min(64, std::max(0, get_int(QUICK_ACKS, 16)));
+	}
+
+
+	int RegistrySettings::get_busy_poll() const
+	{
+		return std::min(10000, std::max(0, get_int(BUSY_POLL, 0)));
+	}
+
+
+	bool RegistrySettings::get_tcp_tunnel_mode() const
+	{
+		return get_int(TCP_TUNNEL_MODE, 1) != 0;
+	}
+
+
+	bool RegistrySettings::get_session_cache() const
+	{
+		return get_bool(SESSION_CACHE);
+	}
+
+
+	bool RegistrySettings::get_reuse_connection() const
+	{
+		return get_bool(REUSE_CONNECTION);
+	}
+
+
+	bool RegistrySettings::get_aead_benchmark() const
+	{
+		return get_bool(AEAD_BENCHMARK);
+	}
+
+
+	bool RegistrySettings::get_dtls() const
+	{
+		return get_bool(DTLS);
+	}
+
+
 	bool RegistrySettings::get_bool(const std::wstring& value_name) const
 	{
 		return _key.get_word(value_name, 0) != 0;
@@ -230,6 +319,14 @@ namespace ui {
 	}
 
 
+	uint32_t RegistrySettings::get_rate(const std::wstring& value_name) const
+	{
+		// Rates are saved in KB/s and limited to 1 GB/s.
+		const int rate = std::min(1024 * 1024, std::max(0, get_int(value_name, 0)));
+		return static_cast<uint32_t>(rate) * 1024;
+	}
+
+
 	const std::wstring RegistrySettings::USERNAME_KEYNAME(L"username");
 	const std::wstring RegistrySettings::FIREWALL_KEYNAME(L"firewall");
 	const std::wstring RegistrySettings::HOST_KEYNAME(L"host");
@@ -244,5 +341,23 @@ namespace ui {
 	const std::wstring RegistrySettings::SCREEN_WIDTH(L"width");
 	const std::wstring RegistrySettings::SCREEN_HEIGHT(L"height");
 	const std::wstring RegistrySettings::AUTH_METHOD(L"authmethod");
+	const std::wstring RegistrySettings::CLIENT_UPLOAD_RATE(L"uploadrate");
+	const std::wstring RegistrySettings::CLIENT_DOWNLOAD_RATE(L"downloadrate");
+	const std::wstring RegistrySettings::TUNNEL_UPLOAD_RATE(L"tunneluploadrate");
+	const std::wstring RegistrySettings::TUNNEL_DOWNLOAD_RATE(L"tunneldownloadrate");
+	const std::wstring RegistrySettings::MAX_CONNECTING(L"maxconnecting");
+	const std::wstring RegistrySettings::PPP_RESTART_TIMEOUT(L"ppptimeout");
+	const std::wstring RegistrySettings::PPP_MAX_CONFIGURE(L"pppmaxconfigure");
+	const std::wstring RegistrySettings::PPP_SEED_ADDRESSES(L"pppseed");
+	const std::wstring RegistrySettings::ACK_DELAY(L"ackdelay");
+	const std::wstring RegistrySettings::QUICK_ACKS(L"quickacks");
+	const std::wstring RegistrySettings::BUSY_POLL(L"busypoll");
+	const std::wstring RegistrySettings::TCP_TUNNEL_MODE(L"tunnelmode");
+	const std::wstring RegistrySettings::SESSION_CACHE(L"sessioncache");
+	const std::wstring RegistrySettings::REUSE_CONNECTION(L"reuseconnection");
+	const std::wstring RegistrySettings::AEAD_BENCHMARK(L"aeadbenchmark");
+	const std::wstring RegistrySettings::DTLS(L"dtls");
+	const std::wstring RegistrySettings::SKIP_RX_CHECKSUM(L"skipchecksum");
+	const std::wstring RegistrySettings::ADAPTIVE_RECORDS(L"adaptiverecords");
 
 }
@@ -9,6 +9,8 @@
 
 #include <string>
 #include "fw/AuthTypes.h"
+#include "net/PPInterface.h"
+#include "net/TrafficShaper.h"
 #include "util/RegKey.h"
 #include "ui/ScreenSize.h"
 
@@ -144,6 +146,69 @@ namespace ui {
 		*/
 		void set_auth_method(fw::AuthMethod auth_method);
 
+		/**
+		 * Retrieves the rate limits applied to each client connection.
+		*/
+		net::shaping_rates get_client_rates() const;
+
+		/**
+		 * Retrieves the rate limits applied to the whole tunnel.
+		*/
+		net::shaping_rates get_tunnel_rates() const;
+
+		/**
+		 * Retrieves the maximum number of connections established simultaneously
+		 * through the tunnel.
+		*/
+		int get_max_connecting() const;
+
+		/**
+		 * Retrieves the PPP negotiation parameters.
+		*/
+		net::ppp_config get_ppp_config() const;
+
+		/**
+		 * Retrieves the delay (ms) of the acknowledgments sent inside the tunnel,
+		 * 0 restores the lwIP delayed acknowledgment.
+		*/
+		int get_ack_delay() const;
+
+		/**
+		 * Retrieves the number of segments immediately acknowledged after an
+		 * idle period.
+		*/
+		int get_quick_acks() const;
+
+		/**
+		 * Retrieves the busy poll budget (us) of the tunnel loop, 0 if disabled.
+		*/
+		int get_busy_poll() const;
+
+		/**
+		 * Returns true if the TCP over TCP aware mode is enabled.
+		*/
+		bool get_tcp_tunnel_mode() const;
+
+		/**
+		 * Returns true if the TLS sessions are saved across executions.
+		*/
+		bool get_session_cache() const;
+
+		/**
+		 * Returns true if the tunnel is opened on the portal connection.
+		*/
+		bool get_reuse_connection() const;
+
+		/**
+		 * Returns true if the preferred cipher is selected with a benchmark.
+		*/
+		bool get_aead_benchmark() const;
+
+		/**
+		 * Returns true if the tunnel is opened over DTLS when possible.
+		*/
+		bool get_dtls() const;
+
 	private:
 		//- the registry root key.
 		utl::RegKey _key;
@@ -160,6 +225,9 @@ namespace ui {
 		//- a convenient method to save an int value.
 		void set_int(const std::wstring& value_name, const int value);
 
+		//- a convenient method to retrieve a rate expressed in KB/s.
+		uint32_t get_rate(const std::wstring& value_name) const;
+
 		//- registry keys.
 		static const std::wstring USERNAME_KEYNAME;
 		static const std::wstring FIREWALL_KEYNAME;
@@ -175,6 +243,24 @@ namespace ui {
 		static const std::wstring SCREEN_WIDTH;
 		static const std::wstring SCREEN_HEIGHT;
 		static const std::wstring AUTH_METHOD;
+		static const std::wstring CLIENT_UPLOAD_RATE;
+		static const std::wstring CLIENT_DOWNLOAD_RATE;
+		static const std::wstring TUNNEL_UPLOAD_RATE;
+		static const std::wstring TUNNEL_DOWNLOAD_RATE;
+		static const std::wstring MAX_CONNECTING;
+		static const std::wstring PPP_RESTART_TIMEOUT;
+		static const std::wstring PPP_MAX_CONFIGURE;
+		static const std::wstring PPP_SEED_ADDRESSES;
+		static const std::wstring ACK_DELAY;
+		static const std::wstring QUICK_ACKS;
+		static const std::wstring BUSY_POLL;
+		static const std::wstring TCP_TUNNEL_MODE;
+		static const std::wstring SESSION_CACHE;
+		static const std::wstring REUSE_CONNECTION;
+		static const std::wstring AEAD_BENCHMARK;
+		static const std::wstring DTLS;
+		static const std::wstring SKIP_RX_CHECKSUM;
+		static const std::wstring ADAPTIVE_RECORDS;
 	};
 
 }
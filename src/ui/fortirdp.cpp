@@ -14,6 +14,7 @@
 #include <lwip/arch.h>
 #include <lwip/init.h>
 #include <lwip/dns.h>
+#include "net/TlsMemory.h"
 #include "ui/ConnectDialog.h"
 #include "ui/CmdlineParams.h"
 #include "util/Logger.h"
@@ -89,6 +90,9 @@ int APIENTRY wWinMain(_In_ HINSTANCE hInstance,
 			logger->set_level(utl::LogLevel::LL_TRACE);
 	}
 
+	// Install the mbedtls allocator before any TLS object is created.
+	net::TlsMemory::install();
+
 	// Initialize lwIP stack
 	lwip_init();
 	dns_init();
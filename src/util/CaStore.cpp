@@ -0,0 +1,181 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "CaStore.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mbedtls/asn1.h>
+#include <mbedtls/pem.h>
+#include <mbedtls/platform.h>
+
+
+namespace utl {
+
+	static constexpr const char* PEM_BEGIN_CRT = "-----BEGIN CERTIFICATE-----";
+	static constexpr const char* PEM_END_CRT = "-----END CERTIFICATE-----";
+
+
+	/**
+	 * Locates the subject name (tag and length included) in a DER certificate.
+	*/
+	static bool get_subject(const unsigned char* der, size_t len, const unsigned char*& subject, size_t& subject_len)
+	{
+		unsigned char* p = const_cast<unsigned char*>(der);
+		const unsigned char* end = der + len;
+		size_t tag_len;
+
+		// Certificate and TBSCertificate sequences.
+		for (int i = 0; i < 2; i++) {
+			if (::mbedtls_asn1_get_tag(&p, end, &tag_len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE))
+				return false;
+			end = p + tag_len;
+		}
+
+		// Optional version.
+		if (::mbedtls_asn1_get_tag(&p, end, &tag_len, MBEDTLS_ASN1_CONTEXT_SPECIFIC | MBEDTLS_ASN1_CONSTRUCTED | 0) == 0)
+			p += tag_len;
+
+		// Serial number, signature algorithm, issuer and validity.
+		static const int skipped_tags[] = {
+			MBEDTLS_ASN1_INTEGER,
+			MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE,
+			MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE,
+			MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE
+		};
+		for (const int tag : skipped_tags) {
+			if (::mbedtls_asn1_get_tag(&p, end, &tag_len, tag))
+				return false;
+			p += tag_len;
+		}
+
+		subject = p;
+		if (::mbedtls_asn1_get_tag(&p, end, &tag_len, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE))
+			return false;
+		subject_len = (p + tag_len) - subject;
+
+		return true;
+	}
+
+
+	CaStore::CaStore() :
+		_der(),
+		_certs(),
+		_index(),
+		_skipped(0)
+	{
+	}
+
+
+	CaStore::~CaStore()
+	{
+	}
+
+
+	utl::mbed_err CaStore::load(const char* filename)
+	{
+		std::ifstream ifs{ filename, std::ios::in | std::ios::binary };
+		if (!ifs)
+			return MBEDTLS_ERR_X509_FILE_IO_ERROR;
+
+		// The PEM decoder expects a null terminated string.
+		std::vector<char> buffer{ std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>() };
+		if (ifs.bad())
+			return MBEDTLS_ERR_X509_FILE_IO_ERROR;
+		buffer.push_back('\0');
+
+		mbed_err rc = 0;
+		const char* p = std::strstr(buffer.data(), PEM_BEGIN_CRT);
+
+		if (!p) {
+			// The file holds a single DER certificate.
+			if (!add(reinterpret_cast<const unsigned char*>(buffer.data()), buffer.size() - 1))
+				rc = MBEDTLS_ERR_X509_INVALID_FORMAT;
+		}
+
+		while (p) {
+			mbedtls_pem_context pem;
+			size_t use_len = 0;
+
+			::mbedtls_pem_init(&pem);
+			const mbed_err pem_rc = ::mbedtls_pem_read_buffer(&pem, PEM_BEGIN_CRT, PEM_END_CRT,
+				reinterpret_cast<const unsigned char*>(p), nullptr, 0, &use_len);
+
+			// An invalid certificate is skipped, the next ones are loaded.
+			if (pem_rc == 0) {
+				size_t der_len;
+				const unsigned char* const der = ::mbedtls_pem_get_buffer(&pem, &der_len);
+				if (!add(der, der_len))
+					_skipped++;
+			}
+			else {
+				_skipped++;
+				use_len = std::strlen(PEM_BEGIN_CRT);
+			}
+			::mbedtls_pem_free(&pem);
+
+			p = std::strstr(p + use_len, PEM_BEGIN_CRT);
+		}
+
+		if (rc == 0 && _certs.empty())
+			rc = MBEDTLS_ERR_X509_INVALID_FORMAT;
+
+		return rc;
+	}
+
+
+	bool CaStore::add(const unsigned char* der, size_t len)
+	{
+		const unsigned char* subject;
+		size_t subject_len;
+
+		if (!get_subject(der, len, subject, subject_len))
+			return false;
+
+		_index.emplace(std::string(reinterpret_cast<const char*>(subject), subject_len), _certs.size());
+		_certs.push_back(cert_ref{ _der.size(), len });
+		_der.insert(_der.end(), der, der + len);
+
+		return true;
+	}
+
+
+	int CaStore::ca_cb(void* ctx, const mbedtls_x509_crt* child, mbedtls_x509_crt** candidates)
+	{
+		const CaStore* const store = static_cast<const CaStore*>(ctx);
+		const std::string issuer(reinterpret_cast<const char*>(child->issuer_raw.p), child->issuer_raw.len);
+		const auto range = store->_index.equal_range(issuer);
+		mbedtls_x509_crt* chain = nullptr;
+
+		*candidates = nullptr;
+
+		for (auto it = range.first; it != range.second; ++it) {
+			if (!chain) {
+				chain = static_cast<mbedtls_x509_crt*>(::mbedtls_calloc(1, sizeof(mbedtls_x509_crt)));
+				if (!chain)
+					return MBEDTLS_ERR_X509_ALLOC_FAILED;
+				::mbedtls_x509_crt_init(chain);
+			}
+
+			// A certificate that can not be parsed is not a candidate.
+			const cert_ref& ref = store->_certs[it->second];
+			::mbedtls_x509_crt_parse_der(chain, store->_der.data() + ref.offset, ref.len);
+		}
+
+		if (chain && !chain->raw.p) {
+			::mbedtls_x509_crt_free(chain);
+			::mbedtls_free(chain);
+			chain = nullptr;
+		}
+
+		*candidates = chain;
+
+		return 0;
+	}
+
+}
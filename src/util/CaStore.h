@@ -0,0 +1,96 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <mbedtls/x509_crt.h>
+#include "util/ErrUtil.h"
+
+
+namespace utl {
+
+	/**
+	* CaStore: the trusted CA certificates.
+	*
+	* The certificates of the CA bundle are decoded to DER and indexed by
+	* their subject when the bundle is loaded, they are not parsed.  When a
+	* certificate chain is verified, mbedtls asks the store for the parents
+	* of each certificate; only the CA certificates whose subject matches the
+	* issuer of that certificate are parsed.  The cost of loading the bundle
+	* and of a verification does not depend on the size of the bundle.
+	*
+	* The subject and the issuer names are compared as encoded in the
+	* certificates.
+	*/
+	class CaStore final
+	{
+	public:
+		CaStore();
+		~CaStore();
+
+		CaStore(const CaStore& other) = delete;
+		CaStore& operator=(const CaStore& other) = delete;
+
+		/**
+		 * Loads the certificates from a PEM bundle or a DER file.
+		 *
+		 * The invalid certificates of a bundle are skipped and counted.
+		 *
+		 * @return 0 if at least one certificate is loaded or an mbedtls error code.
+		*/
+		utl::mbed_err load(const char* filename);
+
+		/**
+		 * Returns the number of certificates in the store.
+		*/
+		inline size_t size() const noexcept { return _certs.size(); }
+
+		/**
+		 * Returns the number of invalid certificates skipped by load.
+		*/
+		inline size_t skipped() const noexcept { return _skipped; }
+
+		/**
+		 * The trusted certificate callback passed to mbedtls_ssl_conf_ca_cb.
+		 *
+		 * @param ctx        A pointer to the store.
+		 * @param child      The certificate of which the parents are searched.
+		 * @param candidates The parsed candidates, mbedtls frees the list.
+		 *
+		 * @return 0 if successful or an mbedtls error code.
+		*/
+		static int ca_cb(void* ctx, const mbedtls_x509_crt* child, mbedtls_x509_crt** candidates);
+
+	private:
+		// The DER certificates stored one after the other.
+		std::vector<unsigned char> _der;
+
+		// Offset and length of each certificate in _der.
+		struct cert_ref {
+			size_t offset;
+			size_t len;
+		};
+		std::vector<cert_ref> _certs;
+
+		// The index of the certificates by subject name (DER).
+		std::unordered_multimap<std::string, size_t> _index;
+
+		// The number of invalid certificates found in the bundle.
+		size_t _skipped;
+
+		// Adds a DER certificate, returns false if its subject can not be found.
+		bool add(const unsigned char* der, size_t len);
+	};
+
+	// A unique pointer to a CA store
+	using CaStorePtr = std::unique_ptr<CaStore>;
+
+}
@@ -183,6 +183,35 @@ namespace utl {
 	}
 
 
+	size_t PBufQueue::copy(uint8_t* data, size_t len) const noexcept
+	{
+		if (is_empty())
+			return 0;
+
+		return ::pbuf_copy_partial(_chain, data, static_cast<u16_t>(std::min<size_t>(len, UINT16_MAX)),
+			static_cast<u16_t>(_offset));
+	}
+
+
+	bool PBufQueue::skip(size_t len) noexcept
+	{
+		TRACE_ENTER_FMT(_logger, "queue size=%zu len=%zu", size(), len);
+		bool rc = true;
+
+		while (rc && len > 0) {
+			rc = !is_empty();
+			if (rc) {
+				const size_t available = std::min(len, pbuf_len(_chain) - _offset);
+
+				rc = move(available);
+				len -= available;
+			}
+		}
+
+		return rc;
+	}
+
+
 	size_t PBufQueue::pbuf_len(const pbuf* buffer) noexcept
 	{
 		return static_cast<size_t>(buffer->len);
@@ -161,6 +161,23 @@ namespace utl {
 		*/
 		bool move(size_t len) noexcept;
 
+		/**
+		 * Copies the first bytes of the queue without removing them.
+		 *
+		 * @param data The destination buffer.
+		 * @param len  The maximum number of bytes to copy.
+		 *
+		 * @return The number of bytes copied.
+		*/
+		size_t copy(uint8_t* data, size_t len) const noexcept;
+
+		/**
+		 * Removes the first bytes of the queue, the bytes can span several pbufs.
+		 *
+		 * @return false if the queue holds less than `len` bytes.
+		*/
+		bool skip(size_t len) noexcept;
+
 	private:
 		// The class name
 		static const char* __class__;
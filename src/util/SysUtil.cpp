@@ -81,4 +81,24 @@ namespace utl {
 #endif
 	}
 
+
+	uint64_t now_us() noexcept
+	{
+		// The frequency is fixed at boot, it is read once.
+		static const uint64_t freq = []() {
+			LARGE_INTEGER frequency;
+			::QueryPerformanceFrequency(&frequency);
+			return static_cast<uint64_t>(frequency.QuadPart);
+		}();
+
+		LARGE_INTEGER now;
+		::QueryPerformanceCounter(&now);
+
+		// Split the conversion to avoid an overflow of the multiplication.
+		const uint64_t seconds = now.QuadPart / freq;
+		const uint64_t remainder = now.QuadPart % freq;
+
+		return seconds * 1000000 + remainder * 1000000 / freq;
+	}
+
 }
@@ -7,6 +7,7 @@
 */
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 
@@ -23,4 +24,7 @@ namespace utl {
 
 	// Returns platform cpu
 	std::string get_plaform();
+
+	// Returns a monotonic time in microseconds
+	uint64_t now_us() noexcept;
 }
@@ -0,0 +1,62 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#include "TokenBucket.h"
+
+#include <algorithm>
+#include <cstdint>
+
+
+namespace utl {
+
+	// The bucket holds at most 250 ms of traffic but never less than 4 KB.
+	// A smaller bucket would not be able to hold a full TCP segment.
+	static constexpr uint64_t BURST_DURATION = 250;
+	static constexpr uint64_t MIN_CAPACITY = 4096;
+
+
+	TokenBucket::TokenBucket(uint32_t rate, uint32_t now) :
+		_rate(rate),
+		_capacity(std::max(static_cast<uint64_t>(rate) * BURST_DURATION, MIN_CAPACITY * 1000)),
+		_tokens(_capacity),
+		_last_refill(now)
+	{
+	}
+
+
+	void TokenBucket::refill(uint32_t now) noexcept
+	{
+		// Unsigned arithmetic handles the wrap around of the clock.
+		const uint32_t elapsed = now - _last_refill;
+		_last_refill = now;
+
+		if (is_unlimited() || elapsed == 0)
+			return;
+
+		// rate is in bytes/s and elapsed in ms, the product is thus expressed
+		// in bytes x 1000 which is the unit of _tokens.
+		const uint64_t added = static_cast<uint64_t>(_rate) * elapsed;
+		_tokens = std::min(_capacity, _tokens + added);
+	}
+
+
+	void TokenBucket::consume(size_t count) noexcept
+	{
+		if (is_unlimited())
+			return;
+
+		const uint64_t used = static_cast<uint64_t>(count) * 1000;
+		_tokens = used > _tokens ? 0 : _tokens - used;
+	}
+
+
+	size_t TokenBucket::available() const noexcept
+	{
+		return is_unlimited() ? SIZE_MAX : static_cast<size_t>(_tokens / 1000);
+	}
+
+}
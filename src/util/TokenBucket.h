@@ -0,0 +1,80 @@
+/*!
+* This file is part of FortiRDP
+*
+* Copyright (C) 2025 Jean-Noel Meurisse
+* SPDX-License-Identifier: Apache-2.0
+*
+*/
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace utl {
+
+	/**
+	* A token bucket used to limit a data rate.
+	*
+	* The bucket is filled at a constant rate (bytes per second) up to a
+	* maximum capacity.  Data can be transmitted only if enough tokens are
+	* available in the bucket.  A bucket with a rate of 0 is unlimited.
+	*
+	* The bucket does not read the clock itself, the owner is responsible
+	* for calling refill with a monotonic time expressed in milliseconds.
+	*/
+	class TokenBucket final
+	{
+	public:
+		/**
+		 * Creates a token bucket.
+		 *
+		 * @param rate  The fill rate in bytes per second, 0 means unlimited.
+		 * @param now   The current time in milliseconds.
+		*/
+		explicit TokenBucket(uint32_t rate, uint32_t now);
+
+		/**
+		 * Adds tokens accumulated since the last refill.
+		 *
+		 * @param now  The current time in milliseconds.  The time can wrap around.
+		*/
+		void refill(uint32_t now) noexcept;
+
+		/**
+		 * Removes the specified number of tokens from the bucket.
+		*/
+		void consume(size_t count) noexcept;
+
+		/**
+		 * Returns the number of tokens (bytes) available in the bucket.
+		 * An unlimited bucket always returns SIZE_MAX.
+		*/
+		size_t available() const noexcept;
+
+		/**
+		 * Returns true if this bucket does not limit the rate.
+		*/
+		inline bool is_unlimited() const noexcept { return _rate == 0; }
+
+		/**
+		 * Returns the fill rate in bytes per second.
+		*/
+		inline uint32_t rate() const noexcept { return _rate; }
+
+	private:
+		// The fill rate in bytes per second.
+		const uint32_t _rate;
+
+		// The bucket capacity, expressed in bytes x 1000.
+		const uint64_t _capacity;
+
+		// Available tokens, expressed in bytes x 1000 to avoid losing
+		// fractions of bytes when the bucket is frequently refilled.
+		uint64_t _tokens;
+
+		// Time of the last refill.
+		uint32_t _last_refill;
+	};
+
+}